@@ -0,0 +1,127 @@
+/**
+ * @file    button.c
+ * @brief   Vertical-counter debouncer for all buttons of one port
+ * @author  Joshua
+ * @date    2025-11-02
+ */
+
+#include "button.h"
+
+#define BUTTON_LONG_SAMPLES (BUTTON_LONG_MS / BUTTON_SAMPLE_MS)
+#define BUTTON_REPEAT_SAMPLES (BUTTON_REPEAT_MS / BUTTON_SAMPLE_MS)
+
+_Static_assert((BUTTON_QUEUE_SIZE & (BUTTON_QUEUE_SIZE - 1)) == 0, "BUTTON_QUEUE_SIZE must be a power of two");
+
+static GPIO_TypeDef *buttonPort = 0;
+static uint16_t buttonMask      = 0;
+
+// Debounced state and the two bit planes of a 2-bit counter per pin
+static uint16_t state = 0;
+static uint16_t cnt0  = 0;
+static uint16_t cnt1  = 0;
+
+// Samples since each button's stable press, indexed by pin
+static uint16_t held[16];
+
+// Single producer (Button_Poll) single consumer (Button_GetEvent) queue
+static ButtonEvent queue[BUTTON_QUEUE_SIZE];
+static volatile uint8_t head = 0;
+static volatile uint8_t tail = 0;
+static uint32_t dropped      = 0;
+
+/**
+ * @brief Queues one event per set bit of a mask.
+ */
+static void Button_Push(uint16_t pins, ButtonEventType type) {
+  for (uint8_t pin = 0; pins; pin++, pins >>= 1) {
+    if (!(pins & 1))
+      continue;
+
+    uint8_t next = (head + 1) & (BUTTON_QUEUE_SIZE - 1);
+    if (next == tail) {
+      dropped++;
+      continue;
+    }
+
+    queue[head] = (ButtonEvent){.pin = pin, .type = type};
+    head        = next;
+  }
+}
+
+void Button_Init(GPIO_TypeDef *port, uint16_t mask) {
+  buttonPort = port;
+  buttonMask = mask;
+  state      = 0;
+  cnt0       = 0;
+  cnt1       = 0;
+  head       = 0;
+  tail       = 0;
+  dropped    = 0;
+
+  for (uint8_t pin = 0; pin < 16; pin++)
+    held[pin] = 0;
+}
+
+void Button_Sample(uint16_t pressed) {
+  // A pin's counter runs while its sample differs from the state and resets otherwise,
+  // the state flips once three samples in a row disagreed with it
+  uint16_t delta = (pressed & buttonMask) ^ state;
+  cnt1           = (cnt1 ^ cnt0) & delta;
+  cnt0           = ~cnt0 & delta;
+
+  uint16_t toggle = delta & cnt0 & cnt1;
+  cnt0 &= ~toggle;
+  cnt1 &= ~toggle;
+  state ^= toggle;
+
+  if (toggle) {
+    Button_Push(toggle & state, BUTTON_EVENT_PRESS);
+    Button_Push(toggle & ~state, BUTTON_EVENT_RELEASE);
+  }
+
+  // Long press and repeat per button, pressing a second one does not restart the first
+  uint16_t pins = state;
+  for (uint8_t pin = 0; pins; pin++, pins >>= 1) {
+    if (!(pins & 1))
+      continue;
+
+    if (toggle & (1U << pin)) {
+      held[pin] = 0;
+      continue;
+    }
+
+    held[pin]++;
+
+    if (held[pin] == BUTTON_LONG_SAMPLES) {
+      Button_Push(1U << pin, BUTTON_EVENT_LONG);
+    } else if (held[pin] == BUTTON_LONG_SAMPLES + BUTTON_REPEAT_SAMPLES) {
+      Button_Push(1U << pin, BUTTON_EVENT_REPEAT);
+      held[pin] = BUTTON_LONG_SAMPLES;
+    }
+  }
+}
+
+void Button_Poll(void) {
+  if (!buttonPort)
+    return;
+
+  // Active low, one IDR read for every button
+  Button_Sample((uint16_t)~buttonPort->IDR);
+}
+
+uint16_t Button_GetState(void) {
+  return state;
+}
+
+bool Button_GetEvent(ButtonEvent *event) {
+  if (tail == head)
+    return false;
+
+  *event = queue[tail];
+  tail   = (tail + 1) & (BUTTON_QUEUE_SIZE - 1);
+  return true;
+}
+
+uint32_t Button_GetDropped(void) {
+  return dropped;
+}
@@ -0,0 +1,81 @@
+/**
+ * @file    button.h
+ * @brief   Vertical-counter debouncer for all buttons of one port
+ * @author  Joshua
+ * @date    2025-11-02
+ *
+ * The whole port is sampled with one IDR read and every pin is debounced at once with bitwise
+ * operations on two "vertical" counter words, so adding a button costs no debounce RAM and no
+ * cycles. Only the long press timing keeps a counter per held button.
+ *
+ * Usage:
+ *   Button_Init(GPIOB, PIN_BTN_PLAY_MASK | PIN_BTN_NEXT_MASK | PIN_BTN_BACK_MASK);
+ *   // every BUTTON_SAMPLE_MS, e.g. from a periodic Timer
+ *   Button_Poll();
+ *   // main loop
+ *   ButtonEvent event;
+ *   while (Button_GetEvent(&event)) ...
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "stm32g031xx.h"
+
+#define BUTTON_SAMPLE_MS 5        // Expected interval between Button_Poll calls
+#define BUTTON_LONG_MS 800        // Hold time before BUTTON_EVENT_LONG
+#define BUTTON_REPEAT_MS 200      // Interval of BUTTON_EVENT_REPEAT after a long press
+#define BUTTON_QUEUE_SIZE 16      // Event queue length, must be a power of two
+
+/**
+ * @brief Button event types
+ */
+typedef enum {
+  BUTTON_EVENT_PRESS,      // Stable press, after 3 equal samples
+  BUTTON_EVENT_RELEASE,    // Stable release
+  BUTTON_EVENT_LONG,       // Held for BUTTON_LONG_MS
+  BUTTON_EVENT_REPEAT      // Still held, every BUTTON_REPEAT_MS after the long press
+} ButtonEventType;
+
+/**
+ * @brief One queued event
+ */
+typedef struct {
+  uint8_t pin;             // Pin number of the button
+  ButtonEventType type;
+} ButtonEvent;
+
+/**
+ * @brief Selects the port and the active low button pins, resets the debouncer and the queue.
+ */
+void Button_Init(GPIO_TypeDef *port, uint16_t mask);
+
+/**
+ * @brief Samples the port once and queues the resulting events. Safe from interrupts.
+ */
+void Button_Poll(void);
+
+/**
+ * @brief Feeds one raw sample (bit set = pressed) to the debouncer.
+ * Note:
+ *  Button_Poll calls this with the inverted IDR, it is exposed for other input sources.
+ */
+void Button_Sample(uint16_t pressed);
+
+/**
+ * @brief Returns the debounced state (bit set = pressed).
+ */
+uint16_t Button_GetState(void);
+
+/**
+ * @brief Pops the oldest event.
+ * @return false if the queue is empty.
+ */
+bool Button_GetEvent(ButtonEvent *event);
+
+/**
+ * @brief Returns the number of events dropped because the queue was full.
+ */
+uint32_t Button_GetDropped(void);
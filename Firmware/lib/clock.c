@@ -6,6 +6,7 @@
  */
 
 #include "clock.h"
+#include "clock_pll.h"
 #include "stm32g031xx.h"
 
 #define CLOCK_TIMEOUT 100000UL
@@ -14,33 +15,478 @@
 #define LSE_FREQ 32768UL
 #define LSI_FREQ 32000UL
 
-// --- System & VCO Constraints ---
-#define SYSCLK_MAX_R 64000000UL     // PLLR output max (SYSCLK max)
-#define VCO_MIN 96000000UL          // PLLN caution: VCO min
-#define VCO_MAX 344000000UL         // PLLN caution: VCO max
-#define VCO_INPUT_MIN 2660000UL     // PLLM caution: 2.66 MHz min
-#define VCO_INPUT_MAX 16000000UL    // PLLM caution: 16 MHz max
-#define PCLK_MAX 122000000UL        // PLLP caution: P output max
-#define QCLK_MAX 128000000UL        // PLLQ caution: Q output max
+#define EXTI_IMR1_IM_GPIO 0xFFFFUL    // EXTI lines 0-15 (GPIO)
+
+// PLLCFGR fields written by Clock_ProgramPLL
+#define PLLCFGR_PLAN                                                                                          \
+  (RCC_PLLCFGR_PLLSRC | RCC_PLLCFGR_PLLM | RCC_PLLCFGR_PLLN | RCC_PLLCFGR_PLLP | RCC_PLLCFGR_PLLQ |           \
+   RCC_PLLCFGR_PLLR | RCC_PLLCFGR_PLLREN)
+
+// --- HSI trimming against LSE (TIM16 input capture) ---
+#define TIM16_TI1_LSI 0x1UL          // TISEL: TIM16 TI1 from LSI
+#define TIM16_TI1_LSE 0x2UL          // TISEL: TIM16 TI1 from LSE
+#define TRIM_EDGES 8UL               // LSE periods per capture (IC1PSC = /8)
+#define TRIM_WINDOW 32UL             // Captures per measurement, 256 LSE periods (~7.8 ms)
+#define TRIM_DEADBAND_PPM 1500L      // About half a HSITRIM step
+#define TRIM_MAX_ITERATIONS 16       // Blocking calibration steps before giving up
+
+// --- Flash wait states (voltage range 1) ---
+#define FLASH_0WS_MAX 24000000UL    // HCLK max with 0 wait states
+#define FLASH_1WS_MAX 48000000UL    // HCLK max with 1 wait state
 
 static volatile PowerMode currentPowerMode = POWER_MODE_ACTIVE;
 
 static uint32_t timeout = 0;
 
+// Enabled ClockWakeSource flags
+static uint8_t wakeSources = 0;
+
+// EXTI lines 0-15 unmasked by Clock_ConfigureWakeup itself
+static uint16_t wakeLines = 0;
+
+// Callbacks for the asynchronous bring-up, completed from RCC_IRQHandler
+static ClockReadyCallback volatile readyCallbacks[CLOCK_READY_COUNT];
+
+// RCC ready bits, identical positions in CIER, CIFR and CICR
+static const uint32_t readyFlags[CLOCK_READY_COUNT] = {
+    [CLOCK_READY_HSI] = RCC_CIER_HSIRDYIE,
+    [CLOCK_READY_LSE] = RCC_CIER_LSERDYIE,
+    [CLOCK_READY_LSI] = RCC_CIER_LSIRDYIE,
+    [CLOCK_READY_PLL] = RCC_CIER_PLLRDYIE,
+};
+
+// 64 MHz PLLRCLK for CLOCK_PROFILE_MAX_THROUGHPUT, P and Q unused
+CLOCK_PLL_DEFINE(profilePLL, 64000000UL, 0, 0);
+
+// Named operating points, flash latency follows from the resulting HCLK
+static const ClockProfileConfig profiles[CLOCK_PROFILE_COUNT] = {
+    // 64 MHz everywhere, SPI1 up to 32 MHz
+    [CLOCK_PROFILE_MAX_THROUGHPUT] =
+        {.source = SYSCLK_SRC_PLLRCLK, .hsi_div = CLOCK_DIV_BY_1, .bus = {.ahb_div = 1, .apb1_div = 1, .apb2_div = 1}},
+    // 16 MHz, zero wait states, SPI1 up to 8 MHz
+    [CLOCK_PROFILE_PLAYBACK_ECONOMY] =
+        {.source = SYSCLK_SRC_HSISYS, .hsi_div = CLOCK_DIV_BY_1, .bus = {.ahb_div = 1, .apb1_div = 1, .apb2_div = 1}},
+    // HSI16 / 4 / 4 = 1 MHz HCLK
+    [CLOCK_PROFILE_IDLE] =
+        {.source = SYSCLK_SRC_HSISYS, .hsi_div = CLOCK_DIV_BY_4, .bus = {.ahb_div = 4, .apb1_div = 1, .apb2_div = 1}},
+};
+
+// Called after every change of the clock tree
+static ClockChangeCallback changeCallbacks[CLOCK_MAX_CHANGE_CALLBACKS];
+
+// Background HSI trimming state, updated from TIM16_IRQHandler
+static volatile struct {
+  bool running;
+  bool hsi_clocked;    // TIM16 counts an HSI16 derived clock, captures are only used then
+  uint16_t last;
+  uint8_t captures;
+  uint32_t ticks;
+  int32_t error_ppm;
+} hsiTrim;
+
+// Clock tree registers saved before Stop
+static struct {
+  uint32_t cr;
+  uint32_t cfgr;
+  uint32_t latency;
+} snapshot;
+
+// Cached clock tree, starts at the reset state (HSI16, all prescalers /1)
+static ClockTree clockTree = {
+    .sysclk = HSI_FREQ,
+    .hclk   = HSI_FREQ,
+    .pclk   = HSI_FREQ,
+    .lsi    = LSI_FREQ,
+};
+
+/**
+ * @brief Decodes the PLLRCLK frequency from the current PLLCFGR contents.
+ */
+static uint32_t Clock_GetPLLRCLK(void) {
+  uint32_t pll_m = ((RCC->PLLCFGR & RCC_PLLCFGR_PLLM) >> RCC_PLLCFGR_PLLM_Pos) + 1;
+  uint32_t pll_n = (RCC->PLLCFGR & RCC_PLLCFGR_PLLN) >> RCC_PLLCFGR_PLLN_Pos;
+  uint32_t pll_r = ((RCC->PLLCFGR & RCC_PLLCFGR_PLLR) >> RCC_PLLCFGR_PLLR_Pos) + 1;
+
+  return ((HSI_FREQ / pll_m) * pll_n) / pll_r;
+}
+
+/**
+ * @brief Re-decodes the RCC registers into the cached clock tree and syncs SystemCoreClock.
+ *
+ * Only called after a clock change, so the getters never have to touch RCC or divide.
+ */
+static void Clock_UpdateTree(void) {
+  uint32_t sysclk;
+
+  switch ((RCC->CFGR & RCC_CFGR_SWS) >> RCC_CFGR_SWS_Pos) {
+  case SYSCLK_SRC_HSISYS:
+    sysclk = HSI_FREQ >> ((RCC->CR & RCC_CR_HSIDIV) >> RCC_CR_HSIDIV_Pos);
+    break;
+  case SYSCLK_SRC_PLLRCLK:
+    sysclk = Clock_GetPLLRCLK();
+    break;
+  case SYSCLK_SRC_LSE:
+    sysclk = LSE_FREQ;
+    break;
+  case SYSCLK_SRC_LSI:
+    sysclk = clockTree.lsi;
+    break;
+  default:
+    sysclk = HSI_FREQ;
+    break;
+  }
+
+  clockTree.sysclk = sysclk;
+  clockTree.hclk   = sysclk >> AHBPrescTable[(RCC->CFGR & RCC_CFGR_HPRE) >> RCC_CFGR_HPRE_Pos];
+  clockTree.pclk   = clockTree.hclk >> APBPrescTable[(RCC->CFGR & RCC_CFGR_PPRE) >> RCC_CFGR_PPRE_Pos];
+
+  SystemCoreClock = clockTree.hclk;
+
+  for (uint8_t i = 0; i < CLOCK_MAX_CHANGE_CALLBACKS; i++)
+    if (changeCallbacks[i])
+      changeCallbacks[i](&clockTree);
+}
+
+/**
+ * @brief Returns the number of flash wait states required for the given HCLK (range 1).
+ */
+static uint32_t Clock_GetFlashLatency(uint32_t hclk) {
+  if (hclk <= FLASH_0WS_MAX)
+    return 0;
+  if (hclk <= FLASH_1WS_MAX)
+    return 1;
+  return 2;
+}
+
+/**
+ * @brief Programs the flash latency and waits for the new value to be taken into account.
+ */
+static bool Clock_SetFlashLatency(uint32_t latency) {
+  FLASH->ACR = (FLASH->ACR & ~FLASH_ACR_LATENCY) | (latency << FLASH_ACR_LATENCY_Pos) | FLASH_ACR_DBG_SWEN |
+               FLASH_ACR_ICEN | FLASH_ACR_PRFTEN;
+
+  timeout = 0;
+  while (((FLASH->ACR & FLASH_ACR_LATENCY) >> FLASH_ACR_LATENCY_Pos) != latency && (timeout++ < CLOCK_TIMEOUT))
+    ;
+
+  return ((FLASH->ACR & FLASH_ACR_LATENCY) >> FLASH_ACR_LATENCY_Pos) == latency;
+}
+
+/**
+ * @brief Switches SYSCLK and the AHB/APB prescalers in one transition.
+ *
+ * Flash latency is raised before the switch to cover the fastest HCLK seen on the way and only
+ * lowered once SWS confirms the new source, so the flash is never read with too few wait states.
+ * @param presc New HPRE and PPRE bits of RCC->CFGR.
+ */
+static bool Clock_Transition(SYSCLKSource source, uint32_t sysclk, uint32_t presc) {
+  uint32_t old_cfgr    = RCC->CFGR;
+  uint32_t old_shift   = AHBPrescTable[(old_cfgr & RCC_CFGR_HPRE) >> RCC_CFGR_HPRE_Pos];
+  uint32_t new_shift   = AHBPrescTable[(presc & RCC_CFGR_HPRE) >> RCC_CFGR_HPRE_Pos];
+  uint32_t old_latency = (FLASH->ACR & FLASH_ACR_LATENCY) >> FLASH_ACR_LATENCY_Pos;
+  uint32_t new_latency = Clock_GetFlashLatency(sysclk >> new_shift);
+
+  // Source and prescaler may not change on the same cycle, cover the worst mix of both
+  uint32_t peak_sysclk = (sysclk > clockTree.sysclk) ? sysclk : clockTree.sysclk;
+  uint32_t min_shift   = (new_shift < old_shift) ? new_shift : old_shift;
+  uint32_t latency     = Clock_GetFlashLatency(peak_sysclk >> min_shift);
+  if (latency < old_latency)
+    latency = old_latency;
+
+  // Raise the wait states before speeding up
+  if (latency > old_latency && !Clock_SetFlashLatency(latency))
+    return false;
+
+  // No ISR may run between the switch and the change callbacks recomputing their prescalers
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+
+  // clear and set the new clock source and prescalers
+  RCC->CFGR = (old_cfgr & ~(RCC_CFGR_SW | RCC_CFGR_HPRE | RCC_CFGR_PPRE)) | (source << RCC_CFGR_SW_Pos) | presc;
+
+  // wait for it to be switched
+  timeout = 0;
+  while (((RCC->CFGR & RCC_CFGR_SWS) >> RCC_CFGR_SWS_Pos) != source && (timeout++ < CLOCK_TIMEOUT))
+    ;
+
+  if (((RCC->CFGR & RCC_CFGR_SWS) >> RCC_CFGR_SWS_Pos) != source) {
+    // Switch was refused, put the old prescalers and wait states back
+    RCC->CFGR = (RCC->CFGR & ~(RCC_CFGR_SW | RCC_CFGR_HPRE | RCC_CFGR_PPRE)) |
+                (old_cfgr & (RCC_CFGR_SW | RCC_CFGR_HPRE | RCC_CFGR_PPRE));
+    __set_PRIMASK(primask);
+
+    if (latency > old_latency)
+      Clock_SetFlashLatency(old_latency);
+    return false;
+  }
+
+  Clock_UpdateTree();
+  __set_PRIMASK(primask);
+
+  // Only lower the wait states once running from the slower clock
+  if (new_latency < latency)
+    return Clock_SetFlashLatency(new_latency);
+
+  // Make sure the caches stay enabled when the latency is unchanged
+  if (new_latency == old_latency)
+    FLASH->ACR |= (FLASH_ACR_DBG_SWEN | FLASH_ACR_ICEN | FLASH_ACR_PRFTEN);
+
+  return true;
+}
+
+/**
+ * @brief Switches SYSCLK to an already running source, keeping the current prescalers.
+ */
+static bool Clock_SwitchSYSCLK(SYSCLKSource source, uint32_t sysclk) {
+  return Clock_Transition(source, sysclk, RCC->CFGR & (RCC_CFGR_HPRE | RCC_CFGR_PPRE));
+}
+
+/**
+ * @brief Validates a bus configuration and encodes it into HPRE and PPRE bits.
+ * Note:
+ *  The G0 has a single APB, apb2_div must match apb1_div.
+ */
+static bool Clock_EncodeBus(const ClockBusConfig *config, uint32_t *presc) {
+  uint32_t ahb_shift = 0;
+  uint32_t apb_shift = 0;
+
+  // Both dividers must be powers of two
+  if (!config->ahb_div || (config->ahb_div & (config->ahb_div - 1)))
+    return false;
+  if (!config->apb1_div || (config->apb1_div & (config->apb1_div - 1)))
+    return false;
+  if (config->apb2_div != config->apb1_div)
+    return false;
+
+  while ((1U << ahb_shift) < config->ahb_div)
+    ahb_shift++;
+  while ((1U << apb_shift) < config->apb1_div)
+    apb_shift++;
+
+  // AHB: 1 to 512 without 32, APB: 1 to 16
+  if (ahb_shift > 9 || ahb_shift == 5 || apb_shift > 4)
+    return false;
+
+  uint32_t hpre = ahb_shift ? (0x8 | (ahb_shift - 1 - (ahb_shift > 5))) : 0;
+  uint32_t ppre = apb_shift ? (0x4 | (apb_shift - 1)) : 0;
+
+  *presc = (hpre << RCC_CFGR_HPRE_Pos) | (ppre << RCC_CFGR_PPRE_Pos);
+  return true;
+}
+
+/**
+ * @brief Saves the registers that define the clock tree before entering Stop.
+ */
+static void Clock_SaveSnapshot(void) {
+  snapshot.cr      = RCC->CR & (RCC_CR_HSIDIV | RCC_CR_PLLON);
+  snapshot.cfgr    = RCC->CFGR & (RCC_CFGR_SW | RCC_CFGR_HPRE | RCC_CFGR_PPRE);
+  snapshot.latency = (FLASH->ACR & FLASH_ACR_LATENCY) >> FLASH_ACR_LATENCY_Pos;
+}
+
+/**
+ * @brief Puts the clock tree back after Stop without going through the init path.
+ *
+ * The core wakes on HSISYS with the PLL off. PLLCFGR is retained, so only PLLON, the
+ * dividers, the flash latency and SW need to be written back. The cached tree is unchanged.
+ */
+static bool Clock_RestoreSnapshot(void) {
+  if (snapshot.cr & RCC_CR_PLLON) {
+    RCC->CR |= RCC_CR_PLLON;
+
+    timeout = 0;
+    while (!(RCC->CR & RCC_CR_PLLRDY) && (timeout++ < CLOCK_TIMEOUT))
+      ;
+    if (!(RCC->CR & RCC_CR_PLLRDY))
+      return false;
+  }
+
+  RCC->CR = (RCC->CR & ~RCC_CR_HSIDIV) | (snapshot.cr & RCC_CR_HSIDIV);
+
+  // Still on HSISYS here, so raising the latency first is always safe
+  if (!Clock_SetFlashLatency(snapshot.latency))
+    return false;
+
+  RCC->CFGR = (RCC->CFGR & ~(RCC_CFGR_SW | RCC_CFGR_HPRE | RCC_CFGR_PPRE)) | snapshot.cfgr;
+
+  timeout = 0;
+  while ((RCC->CFGR & RCC_CFGR_SWS) >> RCC_CFGR_SWS_Pos != (snapshot.cfgr & RCC_CFGR_SW) >> RCC_CFGR_SW_Pos &&
+         (timeout++ < CLOCK_TIMEOUT))
+    ;
+
+  return (RCC->CFGR & RCC_CFGR_SWS) >> RCC_CFGR_SWS_Pos == (snapshot.cfgr & RCC_CFGR_SW) >> RCC_CFGR_SW_Pos;
+}
+
+/**
+ * @brief Unlocks the backup domain and starts the LSE with high drive strength.
+ * Note:
+ *  The backup domain is left unlocked, the caller locks it again.
+ */
+static bool Clock_StartLSE(void) {
+  // Enable PWR clock and unlock backup domain
+  RCC->APBENR1 |= RCC_APBENR1_PWREN;
+  PWR->CR1 |= PWR_CR1_DBP;
+
+  timeout = 0;
+  while (!(PWR->CR1 & PWR_CR1_DBP) && (timeout++ < CLOCK_TIMEOUT))
+    ;
+
+  if (!(PWR->CR1 & PWR_CR1_DBP))
+    return false;
+
+  // Reset backup domain (optional safety)
+  RCC->BDCR |= RCC_BDCR_BDRST;
+  RCC->BDCR &= ~RCC_BDCR_BDRST;
+
+  // Disable LSE before reconfiguring
+  RCC->BDCR &= ~(RCC_BDCR_LSEON | RCC_BDCR_LSEBYP);
+  // Set high drive strength
+  RCC->BDCR &= ~RCC_BDCR_LSEDRV_Msk;
+  RCC->BDCR |= (3UL << RCC_BDCR_LSEDRV_Pos);
+  // Enable LSE
+  RCC->BDCR |= RCC_BDCR_LSEON;
+
+  return true;
+}
+
+/**
+ * @brief Encodes a PLL plan into its PLLCFGR value, PLLR output enabled.
+ */
+static uint32_t Clock_EncodePLL(const ClockPLLConfig *config) {
+  return RCC_PLLCFGR_PLLSRC_HSI | ((config->pll_m - 1) << RCC_PLLCFGR_PLLM_Pos) |
+         (config->pll_n << RCC_PLLCFGR_PLLN_Pos) | ((config->pll_p - 1) << RCC_PLLCFGR_PLLP_Pos) |
+         ((config->pll_q - 1) << RCC_PLLCFGR_PLLQ_Pos) | ((config->pll_r - 1) << RCC_PLLCFGR_PLLR_Pos) |
+         RCC_PLLCFGR_PLLREN;    // PLLR output so it can be selected as SYSCLK
+}
+
+/**
+ * @brief Stops the PLL and writes the new configuration, leaving PLLON cleared.
+ */
+static bool Clock_ProgramPLL(const ClockPLLConfig *config) {
+  // The PLL cannot be reconfigured while it is driving SYSCLK
+  if (((RCC->CFGR & RCC_CFGR_SWS) >> RCC_CFGR_SWS_Pos) == SYSCLK_SRC_PLLRCLK)
+    return false;
+
+  // Disable PLL
+  RCC->CR &= ~RCC_CR_PLLON;
+  timeout = 0;
+  while ((RCC->CR & RCC_CR_PLLRDY) && (timeout++ < CLOCK_TIMEOUT))
+    ;
+
+  // Configure M, N, P, Q, R in one write, the values come pre-validated from CLOCK_PLL_DEFINE
+  RCC->PLLCFGR = Clock_EncodePLL(config);
+
+  return true;
+}
+
+/**
+ * @brief Registers a ready callback and enables the matching RCC ready interrupt.
+ */
+static void Clock_ArmReady(ClockReady source, ClockReadyCallback callback) {
+  readyCallbacks[source] = callback;
+
+  RCC->CICR = readyFlags[source];
+  RCC->CIER |= readyFlags[source];
+  NVIC_EnableIRQ(RCC_IRQn);
+}
+
+/**
+ * @brief Returns the TIM16 kernel clock, twice PCLK when the APB prescaler is not 1.
+ */
+static uint32_t Clock_GetTimerClock(void) {
+  return (clockTree.pclk == clockTree.hclk) ? clockTree.pclk : (clockTree.pclk << 1);
+}
+
+/**
+ * @brief Starts TIM16 free-running at the kernel clock, capturing every TRIM_EDGES edges of TI1.
+ */
+static void Clock_StartCapture(uint32_t tisel) {
+  RCC->APBENR2 |= RCC_APBENR2_TIM16EN;
+
+  TIM16->CR1   = 0;
+  TIM16->PSC   = 0;
+  TIM16->ARR   = 0xFFFF;
+  TIM16->TISEL = tisel << TIM_TISEL_TI1SEL_Pos;
+  TIM16->CCMR1 = TIM_CCMR1_CC1S_0 | (3UL << TIM_CCMR1_IC1PSC_Pos);    // IC1 on TI1, every 8th edge
+  TIM16->CCER  = TIM_CCER_CC1E;
+  TIM16->EGR   = TIM_EGR_UG;
+  TIM16->SR    = 0;
+  TIM16->CR1   = TIM_CR1_CEN;
+}
+
+/**
+ * @brief Converts timer ticks over one trim window into the HSI error in ppm.
+ */
+static int32_t Clock_GetTrimError(uint32_t ticks) {
+  int32_t expected = (int32_t)(((uint64_t)Clock_GetTimerClock() * TRIM_EDGES * TRIM_WINDOW) / LSE_FREQ);
+
+  return (int32_t)(((int64_t)((int32_t)ticks - expected) * 1000000) / expected);
+}
+
+/**
+ * @brief Moves HSITRIM one step against the measured error.
+ * @return true if the error was outside the deadband.
+ */
+static bool Clock_NudgeHSITrim(int32_t error_ppm) {
+  uint32_t trim = (RCC->ICSCR & RCC_ICSCR_HSITRIM) >> RCC_ICSCR_HSITRIM_Pos;
+
+  if (error_ppm > TRIM_DEADBAND_PPM && trim > 0)
+    trim--;    // HSI too fast
+  else if (error_ppm < -TRIM_DEADBAND_PPM && trim < (RCC_ICSCR_HSITRIM_Msk >> RCC_ICSCR_HSITRIM_Pos))
+    trim++;    // HSI too slow
+  else
+    return false;
+
+  RCC->ICSCR = (RCC->ICSCR & ~RCC_ICSCR_HSITRIM) | (trim << RCC_ICSCR_HSITRIM_Pos);
+  return true;
+}
+
+/**
+ * @brief Polls TIM16 for one window of TRIM_WINDOW captures.
+ * @param ticks Timer ticks between the first and the last capture.
+ */
+static bool Clock_CaptureWindow(uint32_t *ticks) {
+  uint16_t last = 0;
+  *ticks        = 0;
+
+  // One extra capture to get the starting edge
+  for (uint32_t n = 0; n <= TRIM_WINDOW; n++) {
+    timeout = 0;
+    while (!(TIM16->SR & TIM_SR_CC1IF) && (timeout++ < CLOCK_TIMEOUT))
+      ;
+    if (!(TIM16->SR & TIM_SR_CC1IF))
+      return false;
+
+    uint16_t capture = TIM16->CCR1;
+    if (n)
+      *ticks += (uint16_t)(capture - last);
+    last = capture;
+  }
+
+  return true;
+}
+
 bool Clock_ConfigHSIDIV(ClockDiv divider) {
   // if SYSCLK is not from HSIDIV
   if (((RCC->CFGR & RCC_CFGR_SWS) >> RCC_CFGR_SWS_Pos) != SYSCLK_SRC_HSISYS)
     return false;
 
+  // The new divider clocks the core at once, run the change callbacks before any ISR
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+
   // clear and set the div
   RCC->CR &= ~RCC_CR_HSIDIV;
   RCC->CR |= (divider << RCC_CR_HSIDIV_Pos);
 
   // wait for ready
-  while (!(RCC->CR & RCC_CR_HSIRDY))
+  timeout = 0;
+  while (!(RCC->CR & RCC_CR_HSIRDY) && (timeout++ < CLOCK_TIMEOUT))
     ;
 
-  return true;
+  Clock_UpdateTree();
+  __set_PRIMASK(primask);
+
+  return (RCC->CR & RCC_CR_HSIRDY);
 }
 
 bool Clock_InitBaseClock(ClockBase source) {
@@ -55,28 +501,9 @@ bool Clock_InitBaseClock(ClockBase source) {
     return (RCC->CR & RCC_CR_HSIRDY);
 
   case CLOCK_BASE_SOURCE_LSE:
-    // Enable PWR clock and unlock backup domain
-    RCC->APBENR1 |= RCC_APBENR1_PWREN;
-    PWR->CR1 |= PWR_CR1_DBP;
-
-    while (!(PWR->CR1 & PWR_CR1_DBP) && (timeout++ < CLOCK_TIMEOUT))
-      ;
-
-    if (!(PWR->CR1 & PWR_CR1_DBP))
+    if (!Clock_StartLSE())
       return false;
 
-    // Reset backup domain (optional safety)
-    RCC->BDCR |= RCC_BDCR_BDRST;
-    RCC->BDCR &= ~RCC_BDCR_BDRST;
-
-    // Disable LSE before reconfiguring
-    RCC->BDCR &= ~(RCC_BDCR_LSEON | RCC_BDCR_LSEBYP);
-    // Set high drive strength
-    RCC->BDCR &= ~RCC_BDCR_LSEDRV_Msk;
-    RCC->BDCR |= (3UL << RCC_BDCR_LSEDRV_Pos);
-    // Enable LSE
-    RCC->BDCR |= RCC_BDCR_LSEON;
-
     timeout = 0;
     while (!(RCC->BDCR & RCC_BDCR_LSERDY) && (timeout++ < CLOCK_TIMEOUT))
       ;
@@ -158,64 +585,152 @@ bool Clock_IsReady(ClockBase source) {
   }
 }
 
-bool Clock_ConfigurePLL(const ClockPLLConfig *config) {
-  if (!config)
+bool Clock_InitBaseClockAsync(ClockBase source, ClockReadyCallback callback) {
+  if (source > CLOCK_BASE_SOURCE_LSI || !callback)
     return false;
 
-  // Validate PLL input and output frequency ranges
-  if (config->pll_m < 1 || config->pll_m > 8)
-    return false;
-  if (config->pll_n < 8 || config->pll_n > 86)
-    return false;
-  if (config->pll_r < 2 || config->pll_r > 8)
-    return false;
-  if (config->pll_p < 2 || config->pll_p > 32)
-    return false;
-  if (config->pll_q < 2 || config->pll_q > 8)
-    return false;
+  // Already running, the ready flag would never fire
+  if (Clock_IsReady(source)) {
+    callback((ClockReady)source);
+    return true;
+  }
 
-  // PLLM Caution Check (f_VCO_INPUT)
-  uint32_t pll_vco_input = HSI_FREQ / config->pll_m;
-  if (pll_vco_input < VCO_INPUT_MIN || pll_vco_input > VCO_INPUT_MAX)
-    return false;
+  Clock_ArmReady((ClockReady)source, callback);
 
-  // PLLN Caution Check (f_VCO_OUTPUT)
-  uint32_t pll_vco = pll_vco_input * config->pll_n;
-  if (pll_vco < VCO_MIN || pll_vco > VCO_MAX)
-    return false;
+  switch (source) {
+  case CLOCK_BASE_SOURCE_HSI:
+    RCC->CR |= RCC_CR_HSION;
+    return true;
+
+  case CLOCK_BASE_SOURCE_LSE:
+    if (!Clock_StartLSE()) {
+      RCC->CIER &= ~readyFlags[CLOCK_READY_LSE];
+      readyCallbacks[CLOCK_READY_LSE] = 0;
+      return false;
+    }
 
-  // PLLR Caution Check (f_PLLRCLK)
-  uint32_t pll_sysclk = pll_vco / config->pll_r;
-  if (pll_sysclk > SYSCLK_MAX_R)
+    // LSERDY does not need the backup domain unlocked
+    PWR->CR1 &= ~PWR_CR1_DBP;
+    return true;
+
+  case CLOCK_BASE_SOURCE_LSI:
+    RCC->CSR |= RCC_CSR_LSION;
+    return true;
+
+  default:
     return false;
+  }
+}
 
-  // PLLP Caution Check (f_PLLPCLK)
-  uint32_t pll_pclk = pll_vco / config->pll_p;
-  if (pll_pclk > PCLK_MAX)
+bool Clock_CalibrateHSI(void) {
+  // TIM16 must count an HSI derived clock and the LSE must be the reference
+  SYSCLKSource source = (SYSCLKSource)((RCC->CFGR & RCC_CFGR_SWS) >> RCC_CFGR_SWS_Pos);
+  if ((source != SYSCLK_SRC_HSISYS && source != SYSCLK_SRC_PLLRCLK) || !Clock_IsReady(CLOCK_BASE_SOURCE_LSE) ||
+      hsiTrim.running)
     return false;
 
-  // PLLQ Caution Check (f_PLLQCLK)
-  uint32_t pll_qclk = pll_vco / config->pll_q;
-  if (pll_qclk > QCLK_MAX)
+  Clock_StartCapture(TIM16_TI1_LSE);
+
+  bool locked = false;
+  for (uint8_t i = 0; i < TRIM_MAX_ITERATIONS && !locked; i++) {
+    uint32_t ticks;
+    if (!Clock_CaptureWindow(&ticks)) {
+      TIM16->CR1 = 0;
+      return false;
+    }
+
+    hsiTrim.error_ppm = Clock_GetTrimError(ticks);
+    locked            = !Clock_NudgeHSITrim(hsiTrim.error_ppm);
+  }
+
+  TIM16->CR1 = 0;
+  return locked;
+}
+
+/**
+ * @brief Clock change hook of the background trimming, restarts the window at the new timer rate.
+ *
+ * A window straddling a change would mix two TIM16 rates and nudge HSITRIM against a wrong error.
+ * Away from HSI16 (LSI, LSE SYSCLK) the captures say nothing about it, trimming pauses until back.
+ */
+static void Clock_OnTrimClockChange(const ClockTree *tree) {
+  (void)tree;
+  if (!hsiTrim.running)
+    return;
+
+  SYSCLKSource source = (SYSCLKSource)((RCC->CFGR & RCC_CFGR_SWS) >> RCC_CFGR_SWS_Pos);
+
+  hsiTrim.hsi_clocked = (source == SYSCLK_SRC_HSISYS || source == SYSCLK_SRC_PLLRCLK);
+  hsiTrim.captures    = 0;
+  hsiTrim.ticks       = 0;
+
+  // A capture latched before the change must not become the starting edge
+  TIM16->SR = 0;
+}
+
+bool Clock_StartHSITrim(void) {
+  SYSCLKSource source = (SYSCLKSource)((RCC->CFGR & RCC_CFGR_SWS) >> RCC_CFGR_SWS_Pos);
+  if ((source != SYSCLK_SRC_HSISYS && source != SYSCLK_SRC_PLLRCLK) || !Clock_IsReady(CLOCK_BASE_SOURCE_LSE) ||
+      !Clock_RegisterChangeCallback(Clock_OnTrimClockChange))
     return false;
 
-  // Disable PLL
-  RCC->CR &= ~RCC_CR_PLLON;
-  uint32_t timeout = 0;
-  while ((RCC->CR & RCC_CR_PLLRDY) && (timeout++ < CLOCK_TIMEOUT))
-    ;
+  hsiTrim.captures    = 0;
+  hsiTrim.ticks       = 0;
+  hsiTrim.hsi_clocked = true;
+  hsiTrim.running     = true;
+
+  Clock_StartCapture(TIM16_TI1_LSE);
+  TIM16->DIER = TIM_DIER_CC1IE;
+  NVIC_EnableIRQ(TIM16_IRQn);
+
+  return true;
+}
+
+void Clock_StopHSITrim(void) {
+  TIM16->DIER = 0;
+  TIM16->CR1  = 0;
+  NVIC_DisableIRQ(TIM16_IRQn);
+  hsiTrim.running = false;
+}
+
+int32_t Clock_GetHSIError(void) {
+  return hsiTrim.error_ppm;
+}
+
+uint32_t Clock_MeasureLSI(void) {
+  // TIM16 must count an HSI derived clock, the LSI is the measured input
+  SYSCLKSource source = (SYSCLKSource)((RCC->CFGR & RCC_CFGR_SWS) >> RCC_CFGR_SWS_Pos);
+  if ((source != SYSCLK_SRC_HSISYS && source != SYSCLK_SRC_PLLRCLK) || !Clock_IsReady(CLOCK_BASE_SOURCE_LSI))
+    return 0;
+
+  // Borrow TIM16 from the background trimming
+  bool trimming = hsiTrim.running;
+  if (trimming)
+    Clock_StopHSITrim();
+
+  uint32_t ticks;
+  Clock_StartCapture(TIM16_TI1_LSI);
+  bool ok    = Clock_CaptureWindow(&ticks);
+  TIM16->CR1 = 0;
+
+  if (trimming)
+    Clock_StartHSITrim();
+
+  if (!ok || !ticks)
+    return 0;
 
-  // Configure PLL
-  RCC->PLLCFGR = 0;
+  // Only an LSI SYSCLK depends on it, and that is never the case here: the next switch to the LSI
+  // picks the measurement up through Clock_UpdateTree
+  clockTree.lsi = (uint32_t)(((uint64_t)Clock_GetTimerClock() * TRIM_EDGES * TRIM_WINDOW) / ticks);
+  return clockTree.lsi;
+}
 
-  RCC->PLLCFGR |= RCC_PLLCFGR_PLLSRC_HSI;
+bool Clock_ConfigurePLL(const ClockPLLConfig *config) {
+  if (!config)
+    return false;
 
-  // Configure M, N, P, Q, R
-  RCC->PLLCFGR |= ((config->pll_m - 1) << RCC_PLLCFGR_PLLM_Pos);
-  RCC->PLLCFGR |= (config->pll_n << RCC_PLLCFGR_PLLN_Pos);
-  RCC->PLLCFGR |= ((config->pll_p - 1) << RCC_PLLCFGR_PLLP_Pos);
-  RCC->PLLCFGR |= ((config->pll_q - 1) << RCC_PLLCFGR_PLLQ_Pos);
-  RCC->PLLCFGR |= ((config->pll_r - 1) << RCC_PLLCFGR_PLLR_Pos);
+  if (!Clock_ProgramPLL(config))
+    return false;
 
   // Enable PLL
   RCC->CR |= RCC_CR_PLLON;
@@ -225,7 +740,25 @@ bool Clock_ConfigurePLL(const ClockPLLConfig *config) {
   return (RCC->CR & RCC_CR_PLLRDY);
 }
 
+bool Clock_ConfigurePLLAsync(const ClockPLLConfig *config, ClockReadyCallback callback) {
+  if (!config || !callback)
+    return false;
+
+  if (!Clock_ProgramPLL(config))
+    return false;
+
+  Clock_ArmReady(CLOCK_READY_PLL, callback);
+
+  // Enable PLL, PLLRDY completes through RCC_IRQHandler
+  RCC->CR |= RCC_CR_PLLON;
+  return true;
+}
+
 bool Clock_ConfigurePLLPCLKTo64(ClockPLLConfig *config) {
+  // P and Q come from the caller, keep them inside their register ranges
+  if (config->pll_p < 2 || config->pll_p > 32 || config->pll_q < 2 || config->pll_q > 8)
+    return false;
+
   // 16MHz f_VCO_INPUT
   config->pll_m = 1;
 
@@ -268,7 +801,72 @@ bool Clock_DeinitPLL(void) {
   return RCC->CR & RCC_CR_PLLRDY;
 }
 
-void Clock_SetBusDividers(const ClockBusConfig *config);
+bool Clock_SetBusDividers(const ClockBusConfig *config) {
+  uint32_t presc;
+
+  if (!config || !Clock_EncodeBus(config, &presc))
+    return false;
+
+  SYSCLKSource source = (SYSCLKSource)((RCC->CFGR & RCC_CFGR_SWS) >> RCC_CFGR_SWS_Pos);
+  return Clock_Transition(source, clockTree.sysclk, presc);
+}
+
+bool Clock_ApplyProfile(ClockProfile profile) {
+  if (profile >= CLOCK_PROFILE_COUNT)
+    return false;
+
+  return Clock_ApplyConfig(&profiles[profile]);
+}
+
+bool Clock_ApplyConfig(const ClockProfileConfig *config) {
+  uint32_t presc;
+
+  if (!config || !Clock_EncodeBus(&config->bus, &presc))
+    return false;
+
+  if (config->source == SYSCLK_SRC_PLLRCLK) {
+    // A locked PLL is only reused when it runs the profile's plan
+    bool planned = (RCC->CR & RCC_CR_PLLRDY) && (RCC->PLLCFGR & PLLCFGR_PLAN) == Clock_EncodePLL(&profilePLL);
+
+    if (!planned) {
+      // Step down to HSISYS first if the PLL with another plan is driving SYSCLK
+      if (((RCC->CFGR & RCC_CFGR_SWS) >> RCC_CFGR_SWS_Pos) == SYSCLK_SRC_PLLRCLK &&
+          !Clock_SwitchSYSCLK(SYSCLK_SRC_HSISYS, HSI_FREQ >> ((RCC->CR & RCC_CR_HSIDIV) >> RCC_CR_HSIDIV_Pos)))
+        return false;
+
+      if (!Clock_ConfigurePLL(&profilePLL))
+        return false;
+    }
+
+    return Clock_Transition(SYSCLK_SRC_PLLRCLK, Clock_GetPLLRCLK(), presc);
+  }
+
+  if (config->source != SYSCLK_SRC_HSISYS)
+    return false;
+
+  // HSIDIV may already clock the core, keep it and the switch in the same critical section
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+
+  // HSISYS never exceeds 16 MHz, the divider is safe to change at any latency
+  RCC->CR = (RCC->CR & ~RCC_CR_HSIDIV) | (config->hsi_div << RCC_CR_HSIDIV_Pos);
+
+  timeout = 0;
+  while (!(RCC->CR & RCC_CR_HSIRDY) && (timeout++ < CLOCK_TIMEOUT))
+    ;
+
+  bool ok = Clock_Transition(SYSCLK_SRC_HSISYS, HSI_FREQ >> config->hsi_div, presc);
+  __set_PRIMASK(primask);
+
+  if (!ok)
+    return false;
+
+  // Nothing runs from the PLL any more, stop the VCO (Clock_DeinitPLL returns PLLRDY)
+  if ((RCC->CR & RCC_CR_PLLON) && Clock_DeinitPLL())
+    return false;
+
+  return true;
+}
 
 bool Clock_SetSystemClock(SYSCLKSource source) {
   switch (source) {
@@ -276,77 +874,61 @@ bool Clock_SetSystemClock(SYSCLKSource source) {
     if (!Clock_IsReady(CLOCK_BASE_SOURCE_HSI))
       return false;
 
-    // Set the flash speed to zero wait states
-    FLASH->ACR &= ~FLASH_ACR_LATENCY;
-    FLASH->ACR |= (FLASH_ACR_DBG_SWEN | FLASH_ACR_ICEN | FLASH_ACR_PRFTEN);
-
-    // clear and set the new clock source
-    RCC->CFGR &= ~RCC_CFGR_SW;
-    RCC->CFGR |= SYSCLK_SRC_HSISYS;
-
-    // wait for it to be switched
-    while (((RCC->CFGR & RCC_CFGR_SWS) >> RCC_CFGR_SWS_Pos) != SYSCLK_SRC_HSISYS)
-      ;
-
-    return true;
+    return Clock_SwitchSYSCLK(SYSCLK_SRC_HSISYS, HSI_FREQ >> ((RCC->CR & RCC_CR_HSIDIV) >> RCC_CR_HSIDIV_Pos));
   case SYSCLK_SRC_PLLRCLK:
+    // PLL must be locked with the R output enabled
+    if (!(RCC->CR & RCC_CR_PLLRDY) || !(RCC->PLLCFGR & RCC_PLLCFGR_PLLREN))
+      return false;
 
-    return true;
+    return Clock_SwitchSYSCLK(SYSCLK_SRC_PLLRCLK, Clock_GetPLLRCLK());
   case SYSCLK_SRC_LSI:
     if (!Clock_IsReady(CLOCK_BASE_SOURCE_LSI) && Clock_IsInLowPowerMode())
       return false;
 
-    // Set the flash speed to zero wait states
-    FLASH->ACR &= ~FLASH_ACR_LATENCY;
-    FLASH->ACR |= (FLASH_ACR_DBG_SWEN | FLASH_ACR_ICEN | FLASH_ACR_PRFTEN);
-
-    // clear and set the new clock source
-    RCC->CFGR &= ~RCC_CFGR_SW;
-    RCC->CFGR |= SYSCLK_SRC_LSI;
-
-    // wait for it to be switched
-    while (((RCC->CFGR & RCC_CFGR_SWS) >> RCC_CFGR_SWS_Pos) != SYSCLK_SRC_LSI)
-      ;
-
-    return true;
+    return Clock_SwitchSYSCLK(SYSCLK_SRC_LSI, clockTree.lsi);
   case SYSCLK_SRC_LSE:
     if (!Clock_IsReady(CLOCK_BASE_SOURCE_LSE) && Clock_IsInLowPowerMode())
       return false;
 
-    // Set the flash speed to zero wait states
-    FLASH->ACR &= ~FLASH_ACR_LATENCY;
-    FLASH->ACR |= (FLASH_ACR_DBG_SWEN | FLASH_ACR_ICEN | FLASH_ACR_PRFTEN);
-
-    // clear and set the new clock source
-    RCC->CFGR &= ~RCC_CFGR_SW;
-    RCC->CFGR |= SYSCLK_SRC_LSE;
-
-    // wait for it to be switched
-    while (((RCC->CFGR & RCC_CFGR_SWS) >> RCC_CFGR_SWS_Pos) != SYSCLK_SRC_LSE)
-      ;
-
-    return true;
+    return Clock_SwitchSYSCLK(SYSCLK_SRC_LSE, LSE_FREQ);
   default:
     return false;
   }
 }
 
 uint32_t Clock_GetSYSCLK(void) {
-  switch ((RCC->CFGR & RCC_CFGR_SWS) >> RCC_CFGR_SWS_Pos) {
-  case SYSCLK_SRC_HSISYS:
-    return HSI_FREQ / (1 << ((RCC->CR & RCC_CR_HSIDIV) >> RCC_CR_HSIDIV_Pos));
-  case SYSCLK_SRC_LSE:
-    return LSE_FREQ;
-  case SYSCLK_SRC_LSI:
-    return LSI_FREQ;
-  default:
-    return HSI_FREQ;
+  return clockTree.sysclk;
+}
+
+uint32_t Clock_GetHCLK(void) {
+  return clockTree.hclk;
+}
+
+uint32_t Clock_GetPCLK(void) {
+  return clockTree.pclk;
+}
+
+bool Clock_RegisterChangeCallback(ClockChangeCallback callback) {
+  if (!callback)
+    return false;
+
+  for (uint8_t i = 0; i < CLOCK_MAX_CHANGE_CALLBACKS; i++) {
+    if (!changeCallbacks[i] || changeCallbacks[i] == callback) {
+      changeCallbacks[i] = callback;
+      return true;
+    }
   }
+
+  return false;
 }
 
-uint32_t Clock_GetHCLK(void);
+uint32_t Clock_GetLSI(void) {
+  return clockTree.lsi;
+}
 
-uint32_t Clock_GetPCLK(void);
+const ClockTree *Clock_GetTree(void) {
+  return &clockTree;
+}
 
 bool Clock_EnableMCO(MCOSource source, ClockDiv divider) {
   if (divider < CLOCK_DIV_BY_1 || divider > CLOCK_DIV_BY_128)
@@ -381,13 +963,174 @@ void Clock_DisableMCO(void) {
   GPIOA->MODER |= (0UL << GPIO_MODER_MODE8_Pos);
 }
 
-bool Clock_EnterStopMode(void);
+bool Clock_ConfigureWakeup(uint8_t sources, uint16_t exti_lines) {
+  if (sources & ~(CLOCK_WAKE_EXTI | CLOCK_WAKE_LPTIM | CLOCK_WAKE_RTC))
+    return false;
 
-bool Clock_EnterStandbyMode(void);
+  RCC->APBENR1 |= RCC_APBENR1_PWREN;
+
+  uint16_t lines = (sources & CLOCK_WAKE_EXTI) ? exti_lines : 0;
+  uint32_t imr   = EXTI->IMR1;
+
+  // Sleep / Stop: mask again only the GPIO lines unmasked here before, lines enabled by
+  // EXTI_Attach (DREQ, buttons) are never touched
+  imr &= ~(uint32_t)(wakeLines & ~lines);
+  wakeLines = (uint16_t)((wakeLines & lines) | (lines & ~imr));
+  imr |= lines;
+
+  // RTC and LPTIM1 lines belong to this function
+  imr &= ~(EXTI_IMR1_IM19 | EXTI_IMR1_IM29);
+  if (sources & CLOCK_WAKE_RTC)
+    imr |= EXTI_IMR1_IM19;
+  if (sources & CLOCK_WAKE_LPTIM)
+    imr |= EXTI_IMR1_IM29;
+  EXTI->IMR1 = imr;
+
+  // Standby: only the WKUP pins and the internal (RTC) wakeup line survive
+  PWR->CR3 &= ~(PWR_CR3_EWUP6 | PWR_CR3_EIWUL);
+  if (sources & CLOCK_WAKE_EXTI) {
+    PWR->CR4 |= PWR_CR4_WP6;    // BTN_NEXT (PB5) is active low, wake on falling edge
+    PWR->CR3 |= PWR_CR3_EWUP6;
+  }
+  if (sources & CLOCK_WAKE_RTC)
+    PWR->CR3 |= PWR_CR3_EIWUL;
 
-bool Clock_EnterSleepMode(void);
+  wakeSources = sources;
+  return true;
+}
+
+uint8_t Clock_GetWakeup(void) {
+  uint32_t imr  = EXTI->IMR1;
+  uint8_t ready = 0;
+
+  // A source only counts while its line is unmasked, another driver may have masked it since
+  if ((wakeSources & CLOCK_WAKE_EXTI) && (imr & EXTI_IMR1_IM_GPIO))
+    ready |= CLOCK_WAKE_EXTI;
+  if ((wakeSources & CLOCK_WAKE_LPTIM) && (imr & EXTI_IMR1_IM29))
+    ready |= CLOCK_WAKE_LPTIM;
+  if ((wakeSources & CLOCK_WAKE_RTC) && (imr & EXTI_IMR1_IM19))
+    ready |= CLOCK_WAKE_RTC;
+
+  return ready;
+}
+
+bool Clock_EnterStopMode(uint8_t wake) {
+  // Without one of the caller's sources nothing ends the Stop in time, maybe nothing at all
+  if (!(Clock_GetWakeup() & wake))
+    return false;
+
+  // Stop 1: low-power regulator, flash kept powered for a faster wake
+  RCC->APBENR1 |= RCC_APBENR1_PWREN;
+  PWR->CR1 = (PWR->CR1 & ~(PWR_CR1_LPMS | PWR_CR1_FPD_STOP)) | PWR_CR1_LPMS_0;
+
+  Clock_SaveSnapshot();
+
+  // Keep interrupts masked until the clock tree is back, so ISRs never run on HSI16
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+
+  currentPowerMode = POWER_MODE_STOP;
+  SCB->SCR |= SCB_SCR_SLEEPDEEP_Msk;
+  __DSB();
+  __WFI();
+  SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+
+  // Stuck on HSISYS if the PLL did not relock, let the cache and the drivers follow
+  bool restored = Clock_RestoreSnapshot();
+  if (!restored)
+    Clock_UpdateTree();
+  currentPowerMode = POWER_MODE_ACTIVE;
+
+  __set_PRIMASK(primask);
+  return restored;
+}
+
+bool Clock_EnterStandbyMode(void) {
+  if (!(wakeSources & (CLOCK_WAKE_EXTI | CLOCK_WAKE_RTC)))
+    return false;
+
+  RCC->APBENR1 |= RCC_APBENR1_PWREN;
+
+  // Clear stale wakeup flags, otherwise the core wakes immediately
+  PWR->SCR = PWR_SCR_CWUF;
+  PWR->CR1 = (PWR->CR1 & ~PWR_CR1_LPMS) | (PWR_CR1_LPMS_1 | PWR_CR1_LPMS_0);
+
+  currentPowerMode = POWER_MODE_STANDBY;
+  SCB->SCR |= SCB_SCR_SLEEPDEEP_Msk;
+  __DSB();
+  __WFI();
+
+  // Only reached if a wakeup event was already pending, standby exits through reset
+  SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+  currentPowerMode = POWER_MODE_ACTIVE;
+  return false;
+}
+
+bool Clock_EnterSleepMode(void) {
+  // Clocks keep running, nothing to restore on wake
+  currentPowerMode = POWER_MODE_SLEEP;
+  SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+  __DSB();
+  __WFI();
+  currentPowerMode = POWER_MODE_ACTIVE;
+
+  return true;
+}
+
+bool Clock_WokeFromStandby(void) {
+  RCC->APBENR1 |= RCC_APBENR1_PWREN;
+
+  if (!(PWR->SR1 & PWR_SR1_SBF))
+    return false;
+
+  PWR->SCR = PWR_SCR_CSBF | PWR_SCR_CWUF;
+  return true;
+}
 
 bool Clock_IsInLowPowerMode(void) {
   return (currentPowerMode == POWER_MODE_SLEEP || currentPowerMode == POWER_MODE_STOP ||
           currentPowerMode == POWER_MODE_STANDBY);
+}
+
+void RCC_IRQHandler(void) {
+  uint32_t flags = RCC->CIFR & RCC->CIER;
+
+  // Ready interrupts are one-shot
+  RCC->CICR = flags;
+  RCC->CIER &= ~flags;
+
+  for (uint8_t i = 0; i < CLOCK_READY_COUNT; i++) {
+    if (!(flags & readyFlags[i]))
+      continue;
+
+    ClockReadyCallback callback = readyCallbacks[i];
+    readyCallbacks[i]           = 0;
+    if (callback)
+      callback((ClockReady)i);
+  }
+}
+
+void TIM16_IRQHandler(void) {
+  if (!(TIM16->SR & TIM_SR_CC1IF))
+    return;
+
+  uint16_t capture = TIM16->CCR1;
+
+  // SYSCLK left HSI16, nothing to measure until it is back
+  if (!hsiTrim.hsi_clocked)
+    return;
+
+  // First capture of a window only marks the starting edge
+  if (hsiTrim.captures++)
+    hsiTrim.ticks += (uint16_t)(capture - hsiTrim.last);
+  hsiTrim.last = capture;
+
+  if (hsiTrim.captures > TRIM_WINDOW) {
+    hsiTrim.error_ppm = Clock_GetTrimError(hsiTrim.ticks);
+    Clock_NudgeHSITrim(hsiTrim.error_ppm);
+
+    // Next window starts on this edge
+    hsiTrim.captures = 1;
+    hsiTrim.ticks    = 0;
+  }
 }
\ No newline at end of file
@@ -10,6 +10,8 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#define CLOCK_MAX_CHANGE_CALLBACKS 5    // Modules that follow clock tree changes
+
 /**
  * @brief Defines the possible system states
  */
@@ -29,6 +31,22 @@ typedef enum {
   CLOCK_BASE_SOURCE_LSI     // Low-Speed Internal (32 kHz)
 } ClockBase;
 
+/**
+ * @brief Defines the clocks that can complete asynchronously
+ */
+typedef enum {
+  CLOCK_READY_HSI = CLOCK_BASE_SOURCE_HSI,
+  CLOCK_READY_LSE = CLOCK_BASE_SOURCE_LSE,
+  CLOCK_READY_LSI = CLOCK_BASE_SOURCE_LSI,
+  CLOCK_READY_PLL,
+  CLOCK_READY_COUNT
+} ClockReady;
+
+/**
+ * @brief Called from RCC_IRQHandler once an asynchronously started clock is ready
+ */
+typedef void (*ClockReadyCallback)(ClockReady source);
+
 /**
  * @brief Defines the divider values for HSIDIV and MCODIV
  */
@@ -65,6 +83,15 @@ typedef enum {
   MCO_SRC_LSE     = 0b0111
 } MCOSource;
 
+/**
+ * @brief Defines the sources that can wake the core from a low-power mode
+ */
+typedef enum {
+  CLOCK_WAKE_EXTI  = 0x01,    // EXTI lines 0-15 (buttons, VS1053 DREQ); WKUP6 / BTN_NEXT (PB5) in Standby
+  CLOCK_WAKE_LPTIM = 0x02,    // LPTIM1 interrupt, Sleep/Stop only
+  CLOCK_WAKE_RTC   = 0x04     // RTC alarm / wakeup timer, all modes
+} ClockWakeSource;
+
 /**
  * @brief Full configuration for the PLL
  */
@@ -80,11 +107,45 @@ typedef struct {
  * @brief Configuration for the AHB/APB buses
  */
 typedef struct {
-  uint8_t ahb_div;     // 1, 2, 4, 8, 16, 64, 128, 256, 512
+  uint16_t ahb_div;    // 1, 2, 4, 8, 16, 64, 128, 256, 512
   uint8_t apb1_div;    // 1, 2, 4, 8, 16
-  uint8_t apb2_div;    // 1, 2, 4, 8, 16
+  uint8_t apb2_div;    // Single APB on the G0, must match apb1_div
 } ClockBusConfig;
 
+/**
+ * @brief Defines the named clock profiles
+ */
+typedef enum {
+  CLOCK_PROFILE_MAX_THROUGHPUT,      // PLLRCLK 64 MHz, buses undivided
+  CLOCK_PROFILE_PLAYBACK_ECONOMY,    // HSI16, buses undivided, zero wait states
+  CLOCK_PROFILE_IDLE,                // HSI16 / 4, AHB / 4 (1 MHz)
+  CLOCK_PROFILE_COUNT
+} ClockProfile;
+
+/**
+ * @brief SYSCLK source, HSIDIV and bus prescalers applied together by Clock_ApplyConfig
+ */
+typedef struct {
+  SYSCLKSource source;    // SYSCLK_SRC_HSISYS or SYSCLK_SRC_PLLRCLK
+  ClockDiv hsi_div;       // HSIDIV, used when source is SYSCLK_SRC_HSISYS
+  ClockBusConfig bus;     // AHB / APB prescalers
+} ClockProfileConfig;
+
+/**
+ * @brief Cached frequencies of the clock tree, refreshed on every clock change
+ */
+typedef struct {
+  uint32_t sysclk;    // SYSCLK frequency in Hz
+  uint32_t hclk;      // AHB clock (HCLK) frequency in Hz
+  uint32_t pclk;      // APB clock (PCLK) frequency in Hz
+  uint32_t lsi;       // LSI frequency in Hz, nominal until Clock_MeasureLSI
+} ClockTree;
+
+/**
+ * @brief Called after every clock tree change, e.g. to recompute a timer reload value
+ */
+typedef void (*ClockChangeCallback)(const ClockTree *tree);
+
 /**
  * @brief Initializes the HSIDIV to SYSCLK
  * @return true if initialization succeeds, false otherwise.
@@ -97,6 +158,55 @@ bool Clock_ConfigHSIDIV(ClockDiv divider);
  */
 bool Clock_InitBaseClock(ClockBase source);
 
+/**
+ * @brief Starts the specified base clock source without waiting for it.
+ * @return true if the clock was started, false otherwise.
+ * Note:
+ *  callback runs in interrupt context once the ready flag is set, or immediately if the
+ *  clock is already running. Boot can continue while the LSE (hundreds of ms) settles.
+ */
+bool Clock_InitBaseClockAsync(ClockBase source, ClockReadyCallback callback);
+
+/**
+ * @brief Trims HSI16 against the LSE until it is within half a HSITRIM step.
+ * @return true once the HSI is within the deadband, false if it could not be measured.
+ * Note:
+ *  Blocking, about 8 ms per step. Needs the LSE running and SYSCLK derived from HSI16.
+ *  Uses TIM16 input capture on the LSE (TISEL), the timer is free afterwards.
+ */
+bool Clock_CalibrateHSI(void);
+
+/**
+ * @brief Starts trimming HSI16 against the LSE in the background.
+ * @return true if started, false if the LSE is not ready, SYSCLK is not derived from HSI16 or no
+ *  change callback slot is left.
+ * Note:
+ *  TIM16 stays reserved, every 256 LSE periods TIM16_IRQHandler moves HSITRIM by at most one step.
+ *  A clock change restarts the measurement, trimming pauses while SYSCLK is not derived from HSI16.
+ *  Takes one of the CLOCK_MAX_CHANGE_CALLBACKS slots.
+ */
+bool Clock_StartHSITrim(void);
+
+/**
+ * @brief Stops the background HSI trimming and releases TIM16.
+ */
+void Clock_StopHSITrim(void);
+
+/**
+ * @brief Returns the HSI error of the last trim measurement.
+ * @return Error in ppm, positive when the HSI runs fast.
+ */
+int32_t Clock_GetHSIError(void);
+
+/**
+ * @brief Measures the LSI against HSI16 and stores the result in the clock tree.
+ * @return Measured LSI frequency in Hz, 0 if it could not be measured.
+ * Note:
+ *  Blocking, 256 LSI periods (~8 ms). Needs the LSI running and SYSCLK derived from HSI16,
+ *  run Clock_CalibrateHSI first for the best accuracy. Briefly pauses the background HSI trim.
+ */
+uint32_t Clock_MeasureLSI(void);
+
 /**
  * @brief De-initializes the specified base clock source.
  * @return true if deInitialization succeeds, false otherwise.
@@ -110,11 +220,21 @@ bool Clock_DeinitBaseClock(ClockBase source);
 bool Clock_IsReady(ClockBase source);
 
 /**
- * @brief Configures the PLL with the provided parameters.
- * @return void
+ * @brief Configures the PLL with the provided parameters and enables the PLLR output.
+ * @return true if the PLL locks, false if the PLL is driving SYSCLK.
+ * Note:
+ *  The parameters are not checked at runtime, build them with CLOCK_PLL_DEFINE (clock_pll.h).
  */
 bool Clock_ConfigurePLL(const ClockPLLConfig *config);
 
+/**
+ * @brief Configures the PLL and starts it without waiting for the lock.
+ * @return true if the PLL was started, false if the PLL is driving SYSCLK.
+ * Note:
+ *  callback runs in interrupt context once PLLRDY is set.
+ */
+bool Clock_ConfigurePLLAsync(const ClockPLLConfig *config, ClockReadyCallback callback);
+
 /**
  * @brief Configures the PLL to have PLLPCLK at 64MHZ and the parameters at the given value.
  * @return void
@@ -135,14 +255,35 @@ bool Clock_DeinitPLL(void);
 
 /**
  * @brief Configures the PreScalers for the AHB and APB buses.
- * @return void
+ * @return true on success, false if a divider is not supported by the hardware.
+ * Note:
+ *  Flash latency is adjusted around the change like in Clock_SetSystemClock.
+ */
+bool Clock_SetBusDividers(const ClockBusConfig *config);
+
+/**
+ * @brief Applies a named profile: SYSCLK source, HSIDIV, AHB/APB prescalers and flash latency.
+ * @return true on success, false if the PLL does not lock or the switch is refused.
+ * Note:
+ *  A running PLL is reused only if PLLCFGR matches the profile's plan, HSISYS profiles stop the
+ *  PLL once SYSCLK has left it.
  */
-void Clock_SetBusDividers(const ClockBusConfig *config);
+bool Clock_ApplyProfile(ClockProfile profile);
+
+/**
+ * @brief Applies a caller defined operating point like Clock_ApplyProfile.
+ * @param config SYSCLK_SRC_PLLRCLK runs the PLL on the 64 MHz plan of CLOCK_PROFILE_MAX_THROUGHPUT.
+ * @return true on success, false on an unsupported source or divider, a PLL that does not lock or
+ *  a refused switch.
+ */
+bool Clock_ApplyConfig(const ClockProfileConfig *config);
 
 /**
  * @brief Switches the main SYSCLK source and handles Flash latency changes.
  * @return true on successful switch, false if the source is not ready.
  * Note:
+ * - Flash wait states are raised before an upshift and lowered only after a downshift.
+ * - SYSCLK_SRC_PLLRCLK requires the PLL to be locked (Clock_ConfigurePLL / Clock_EnablePLL).
  * - SYSCLK_SRC_HSISYS and SYSCLK_SRC_PLLRCLK are suitable for full-speed operation.
  * - SYSCLK_SRC_LSI and SYSCLK_SRC_LSE are valid but extremely slow (~32 kHz).
  *   Use them only in low-power modes or for RTC-centric applications.
@@ -152,6 +293,8 @@ bool Clock_SetSystemClock(SYSCLKSource source);
 /**
  * @brief Returns the frequency of the System Clock (SYSCLK).
  * @return Frequency in Hz.
+ * Note:
+ *  The getters read the cached clock tree, they never decode the RCC registers.
  */
 uint32_t Clock_GetSYSCLK(void);
 
@@ -167,6 +310,28 @@ uint32_t Clock_GetHCLK(void);
  */
 uint32_t Clock_GetPCLK(void);
 
+/**
+ * @brief Registers a callback that runs after every clock tree change.
+ * @return true if registered, false if the callback table is full.
+ * Note:
+ *  Callbacks run from Clock_SetSystemClock, Clock_SetBusDividers, Clock_ConfigHSIDIV,
+ *  Clock_ApplyProfile and Clock_ApplyConfig with interrupts disabled, in the same critical section
+ *  as the switch itself, so no ISR sees the new clock before the callbacks have followed it.
+ */
+bool Clock_RegisterChangeCallback(ClockChangeCallback callback);
+
+/**
+ * @brief Returns the LSI frequency, measured if Clock_MeasureLSI has run.
+ * @return Frequency in Hz. Use it for LSI-clocked LPTIM / RTC timebases.
+ */
+uint32_t Clock_GetLSI(void);
+
+/**
+ * @brief Returns the cached clock tree.
+ * @return Pointer to the clock tree, valid until the next clock change.
+ */
+const ClockTree *Clock_GetTree(void);
+
 /**
  * @brief Enables the MCO pin to output a specified clock.
  * @return true on successful switch, false if the source is not ready.
@@ -180,21 +345,54 @@ bool Clock_EnableMCO(MCOSource source, ClockDiv divider);
  */
 void Clock_DisableMCO(void);
 
+/**
+ * @brief Selects which sources may wake the core from Sleep, Stop and Standby.
+ * @param sources Bitwise OR of ClockWakeSource flags.
+ * @param exti_lines Mask of EXTI lines 0-15 to unmask when CLOCK_WAKE_EXTI is set.
+ * @return true on success, false on an unknown source flag.
+ * Note:
+ *  Only the RTC and LPTIM1 lines and the GPIO lines unmasked by an earlier call are masked
+ *  again, lines enabled through EXTI_Attach stay as they are.
+ */
+bool Clock_ConfigureWakeup(uint8_t sources, uint16_t exti_lines);
+
+/**
+ * @brief Returns the wake sources that are enabled and whose EXTI line is currently unmasked.
+ * @return Bitwise OR of ClockWakeSource flags.
+ */
+uint8_t Clock_GetWakeup(void);
+
 /**
  * @brief Configures the system and enters Stop mode.
+ * @param wake ClockWakeSource flags the caller relies on to end the Stop, e.g. CLOCK_WAKE_LPTIM
+ *  with the compare armed for its deadline.
+ * @return true once woken with the clock tree (PLL, dividers, flash latency) restored, false if
+ *  none of @p wake can wake the core (Stop not entered) or the PLL did not relock.
+ * Note:
+ *  Interrupts stay masked until the clock tree is restored, pending ISRs then run at full speed.
  */
-bool Clock_EnterStopMode(void);
+bool Clock_EnterStopMode(uint8_t wake);
 
 /**
  * @brief Configures the system and enters Standby mode.
+ * @return false if standby could not be entered, on success the core wakes through reset.
+ * Note:
+ *  RAM and registers are lost, check Clock_WokeFromStandby at boot.
  */
 bool Clock_EnterStandbyMode(void);
 
 /**
  * @brief Configures the system and enters Sleep mode.
+ * @return true once woken by any enabled interrupt.
  */
 bool Clock_EnterSleepMode(void);
 
+/**
+ * @brief Checks and clears the standby flag.
+ * @return true if the last reset was a wakeup from Standby.
+ */
+bool Clock_WokeFromStandby(void);
+
 /**
  * @brief Checks of the system is in a low powered mode
  * @return Returns true if the system is currently in a low-power mode.
@@ -0,0 +1,97 @@
+/**
+ * @file    clock_pll.h
+ * @brief   Compile-time PLL parameter solver for STM32G031K8T6
+ * @author  Joshua
+ * @date    2025-11-02
+ *
+ * Picks M/N/R/P/Q for the HSI16-fed PLL from the wanted PLLRCLK, PLLPCLK and PLLQCLK
+ * frequencies. Every limit from the reference manual is checked with _Static_assert, so an
+ * impossible clock plan fails the build instead of failing Clock_ConfigurePLL on the board.
+ *
+ * Usage:
+ *   CLOCK_PLL_DEFINE(pll_cfg, 64000000UL, 64000000UL, 32000000UL);
+ *   Clock_ConfigurePLL(&pll_cfg);
+ *
+ * A P or Q frequency of 0 means "unused", the output is then left at its largest divider.
+ */
+
+#pragma once
+
+#include "clock.h"
+
+// --- PLL input ---
+#define PLL_IN_FREQ 16000000ULL    // HSI16 feeds the PLL
+
+// --- System & VCO Constraints ---
+#define PLL_R_MAX 64000000ULL            // PLLR output max (SYSCLK max)
+#define PLL_P_MAX 122000000ULL           // PLLP output max
+#define PLL_Q_MAX 128000000ULL           // PLLQ output max
+#define PLL_VCO_MIN 96000000ULL          // VCO output min
+#define PLL_VCO_MAX 344000000ULL         // VCO output max
+#define PLL_VCO_INPUT_MIN 2660000ULL     // VCO input min (after PLLM)
+#define PLL_VCO_INPUT_MAX 16000000ULL    // VCO input max (after PLLM)
+
+/**
+ * @brief True when @p vco divides exactly down to @p freq with a divider in [lo, hi].
+ * A frequency of 0 is always accepted (output unused).
+ */
+#define PLL_OUT_OK(vco, freq, lo, hi)                                                                         \
+  ((freq) == 0 || ((vco) % ((freq) ? (freq) : 1) == 0 && (vco) / ((freq) ? (freq) : 1) >= (lo) &&             \
+                   (vco) / ((freq) ? (freq) : 1) <= (hi)))
+
+/**
+ * @brief True when M = @p m and R = @p r give a legal PLL for the requested outputs.
+ */
+#define PLL_FITS(m, r, fr, fp, fq)                                                                            \
+  ((m) * PLL_VCO_INPUT_MIN <= PLL_IN_FREQ && PLL_IN_FREQ <= (m) * PLL_VCO_INPUT_MAX &&                        \
+   (r) * (fr) >= PLL_VCO_MIN && (r) * (fr) <= PLL_VCO_MAX && ((r) * (fr) * (m)) % PLL_IN_FREQ == 0 &&         \
+   ((r) * (fr) * (m)) / PLL_IN_FREQ >= 8 && ((r) * (fr) * (m)) / PLL_IN_FREQ <= 86 &&                         \
+   PLL_OUT_OK((r) * (fr), (fp), 2, 32) && PLL_OUT_OK((r) * (fr), (fq), 2, 8))
+
+// Tries every R for one M, lowest VCO first
+#define PLL_TRY_M(m, fr, fp, fq, next)                                                                        \
+  (PLL_FITS(m, 2, fr, fp, fq)   ? (int)(((m) - 1) * 7 + 0)                                                    \
+   : PLL_FITS(m, 3, fr, fp, fq) ? (int)(((m) - 1) * 7 + 1)                                                    \
+   : PLL_FITS(m, 4, fr, fp, fq) ? (int)(((m) - 1) * 7 + 2)                                                    \
+   : PLL_FITS(m, 5, fr, fp, fq) ? (int)(((m) - 1) * 7 + 3)                                                    \
+   : PLL_FITS(m, 6, fr, fp, fq) ? (int)(((m) - 1) * 7 + 4)                                                    \
+   : PLL_FITS(m, 7, fr, fp, fq) ? (int)(((m) - 1) * 7 + 5)                                                    \
+   : PLL_FITS(m, 8, fr, fp, fq) ? (int)(((m) - 1) * 7 + 6)                                                    \
+                                : (next))
+
+/**
+ * @brief Index of the first legal (M, R) pair, or -1 if the plan is impossible.
+ * M is tried from 1 (highest VCO input, lowest jitter) upwards.
+ */
+#define PLL_SOLVE(fr, fp, fq)                                                                                 \
+  PLL_TRY_M(1ULL, fr, fp, fq,                                                                                 \
+            PLL_TRY_M(2ULL, fr, fp, fq,                                                                       \
+                      PLL_TRY_M(3ULL, fr, fp, fq,                                                             \
+                                PLL_TRY_M(4ULL, fr, fp, fq,                                                   \
+                                          PLL_TRY_M(5ULL, fr, fp, fq,                                         \
+                                                    PLL_TRY_M(6ULL, fr, fp, fq,                               \
+                                                              PLL_TRY_M(7ULL, fr, fp, fq,                     \
+                                                                        PLL_TRY_M(8ULL, fr, fp, fq, -1))))))))
+
+// Decodes a solver index back into M, R and the VCO frequency
+#define PLL_IDX_M(idx) ((idx) / 7 + 1)
+#define PLL_IDX_R(idx) ((idx) % 7 + 2)
+#define PLL_IDX_VCO(idx, fr) (PLL_IDX_R(idx) * (unsigned long long)(fr))
+
+/**
+ * @brief Defines a const ClockPLLConfig named @p name for the requested output frequencies.
+ * Fails the build with a readable message if no legal divider set exists.
+ */
+#define CLOCK_PLL_DEFINE(name, fr, fp, fq)                                                                           \
+  _Static_assert((fr) > 0 && (fr) <= PLL_R_MAX, #name ": PLLRCLK must be between 1 Hz and 64 MHz");                  \
+  _Static_assert((fp) <= PLL_P_MAX, #name ": PLLPCLK must not exceed 122 MHz");                                      \
+  _Static_assert((fq) <= PLL_Q_MAX, #name ": PLLQCLK must not exceed 128 MHz");                                      \
+  enum { name##_pll_idx = PLL_SOLVE((unsigned long long)(fr), (unsigned long long)(fp), (unsigned long long)(fq)) }; \
+  _Static_assert(name##_pll_idx >= 0, #name ": no legal PLL M/N/R/P/Q for the requested frequencies");               \
+  static const ClockPLLConfig name = {                                                                               \
+      .pll_m = PLL_IDX_M(name##_pll_idx),                                                                            \
+      .pll_n = (PLL_IDX_VCO(name##_pll_idx, fr) * PLL_IDX_M(name##_pll_idx)) / PLL_IN_FREQ,                          \
+      .pll_r = PLL_IDX_R(name##_pll_idx),                                                                            \
+      .pll_p = (fp) ? PLL_IDX_VCO(name##_pll_idx, fr) / ((fp) ? (fp) : 1) : 32,                                      \
+      .pll_q = (fq) ? PLL_IDX_VCO(name##_pll_idx, fr) / ((fq) ? (fq) : 1) : 8,                                       \
+  }
@@ -0,0 +1,162 @@
+/**
+ * @file    exti.c
+ * @brief   EXTI line driver with per-line callback dispatch for STM32G031K8T6
+ * @author  Joshua
+ * @date    2025-11-02
+ */
+
+#include "exti.h"
+
+// Line groups served by each interrupt vector
+#define EXTI_GROUP_0_1 0x0003UL
+#define EXTI_GROUP_2_3 0x000CUL
+#define EXTI_GROUP_4_15 0xFFF0UL
+
+static EXTICallback callbacks[EXTI_GPIO_LINES];
+static uint16_t attached = 0;
+
+// De Bruijn sequence to find the lowest set bit, the M0+ has no CLZ/CTZ instruction
+static const uint8_t debruijn[32] = {
+    0,  1,  28, 2,  29, 14, 24, 3, 30, 22, 20, 15, 25, 17, 4,  8,
+    31, 27, 13, 23, 21, 19, 16, 7, 26, 12, 18, 6,  11, 5,  10, 9,
+};
+
+/**
+ * @brief Returns the EXTICR port code of a GPIO port, or 0xFF if unknown.
+ */
+static uint8_t EXTI_PortCode(const GPIO_TypeDef *port) {
+  if (port == GPIOA)
+    return 0x00;
+  if (port == GPIOB)
+    return 0x01;
+  if (port == GPIOC)
+    return 0x02;
+  if (port == GPIOD)
+    return 0x03;
+  if (port == GPIOF)
+    return 0x05;
+  return 0xFF;
+}
+
+/**
+ * @brief Returns the interrupt vector serving a line.
+ */
+static IRQn_Type EXTI_LineIRQ(uint8_t pin) {
+  if (pin < 2)
+    return EXTI0_1_IRQn;
+  if (pin < 4)
+    return EXTI2_3_IRQn;
+  return EXTI4_15_IRQn;
+}
+
+/**
+ * @brief Clears and dispatches every pending line of a group.
+ *
+ * Each pending line costs one De Bruijn lookup, independent of its position, so DREQ on line 1
+ * and a button on line 15 see the same latency.
+ */
+static void EXTI_Dispatch(uint32_t group) {
+  uint32_t rising  = EXTI->RPR1 & group;
+  uint32_t falling = EXTI->FPR1 & group;
+
+  // Write 1 to clear, before the callbacks so a new edge during the callback is kept
+  EXTI->RPR1 = rising;
+  EXTI->FPR1 = falling;
+
+  uint32_t pending = rising | falling;
+  while (pending) {
+    uint32_t bit = pending & (0 - pending);
+    uint8_t line = debruijn[(bit * 0x077CB531UL) >> 27];
+    pending &= ~bit;
+
+    EXTIEdge edge = (EXTIEdge)(((rising & bit) ? EXTI_EDGE_RISING : 0) | ((falling & bit) ? EXTI_EDGE_FALLING : 0));
+    if (callbacks[line])
+      callbacks[line](line, edge);
+  }
+}
+
+bool EXTI_Attach(GPIO_TypeDef *port, uint8_t pin, EXTIEdge edge, EXTICallback callback, uint8_t priority) {
+  uint8_t code = EXTI_PortCode(port);
+  if (code == 0xFF || pin >= EXTI_GPIO_LINES || !callback || !(edge & EXTI_EDGE_BOTH))
+    return false;
+
+  uint32_t mask = 1UL << pin;
+
+  // Masked while the routing changes, so no stale edge from the old port fires
+  EXTI->IMR1 &= ~mask;
+
+  uint8_t shift = (pin & 3) << 3;
+
+  EXTI->EXTICR[pin >> 2] = (EXTI->EXTICR[pin >> 2] & ~(0xFFUL << shift)) | ((uint32_t)code << shift);
+
+  callbacks[pin] = callback;
+  attached |= mask;
+
+  EXTI_SetEdge(pin, edge);
+  EXTI->RPR1 = mask;
+  EXTI->FPR1 = mask;
+  EXTI->IMR1 |= mask;
+
+  IRQn_Type irq = EXTI_LineIRQ(pin);
+  NVIC_SetPriority(irq, priority);
+  NVIC_EnableIRQ(irq);
+  return true;
+}
+
+void EXTI_Detach(uint8_t pin) {
+  if (pin >= EXTI_GPIO_LINES)
+    return;
+
+  uint32_t mask = 1UL << pin;
+  EXTI->IMR1 &= ~mask;
+  EXTI->RTSR1 &= ~mask;
+  EXTI->FTSR1 &= ~mask;
+  EXTI->RPR1 = mask;
+  EXTI->FPR1 = mask;
+
+  callbacks[pin] = 0;
+  attached &= ~mask;
+}
+
+void EXTI_Enable(uint8_t pin) {
+  if (pin < EXTI_GPIO_LINES && (attached & (1UL << pin)))
+    EXTI->IMR1 |= 1UL << pin;
+}
+
+void EXTI_Disable(uint8_t pin) {
+  if (pin < EXTI_GPIO_LINES)
+    EXTI->IMR1 &= ~(1UL << pin);
+}
+
+void EXTI_SetEdge(uint8_t pin, EXTIEdge edge) {
+  if (pin >= EXTI_GPIO_LINES)
+    return;
+
+  uint32_t mask = 1UL << pin;
+
+  if (edge & EXTI_EDGE_RISING)
+    EXTI->RTSR1 |= mask;
+  else
+    EXTI->RTSR1 &= ~mask;
+
+  if (edge & EXTI_EDGE_FALLING)
+    EXTI->FTSR1 |= mask;
+  else
+    EXTI->FTSR1 &= ~mask;
+}
+
+uint16_t EXTI_GetLines(void) {
+  return attached;
+}
+
+void EXTI0_1_IRQHandler(void) {
+  EXTI_Dispatch(EXTI_GROUP_0_1);
+}
+
+void EXTI2_3_IRQHandler(void) {
+  EXTI_Dispatch(EXTI_GROUP_2_3);
+}
+
+void EXTI4_15_IRQHandler(void) {
+  EXTI_Dispatch(EXTI_GROUP_4_15);
+}
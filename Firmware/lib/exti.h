@@ -0,0 +1,67 @@
+/**
+ * @file    exti.h
+ * @brief   EXTI line driver with per-line callback dispatch for STM32G031K8T6
+ * @author  Joshua
+ * @date    2025-11-02
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "stm32g031xx.h"
+
+#define EXTI_GPIO_LINES 16    // Lines 0 to 15, one per pin number
+
+/**
+ * @brief Edges that trigger a line
+ */
+typedef enum {
+  EXTI_EDGE_RISING  = 0x01,
+  EXTI_EDGE_FALLING = 0x02,
+  EXTI_EDGE_BOTH    = 0x03
+} EXTIEdge;
+
+/**
+ * @brief Called from the EXTI interrupt
+ * @param line EXTI line (= pin number) that fired.
+ * @param edge The edge(s) seen since the last dispatch, EXTI_EDGE_BOTH if both are pending.
+ */
+typedef void (*EXTICallback)(uint8_t line, EXTIEdge edge);
+
+/**
+ * @brief Routes a pin to its EXTI line and enables the interrupt.
+ * Note:
+ *  A line serves one port at a time, attaching PB3 replaces a previous PA3.
+ * @param priority NVIC priority (0 to 3) of the line group (0_1, 2_3 or 4_15), shared within a group.
+ * @return false on an invalid port, pin, edge or callback.
+ */
+bool EXTI_Attach(GPIO_TypeDef *port, uint8_t pin, EXTIEdge edge, EXTICallback callback, uint8_t priority);
+
+/**
+ * @brief Masks the line, clears its edges and removes the callback.
+ */
+void EXTI_Detach(uint8_t pin);
+
+/**
+ * @brief Unmasks a previously attached line.
+ */
+void EXTI_Enable(uint8_t pin);
+
+/**
+ * @brief Masks a line without forgetting its configuration.
+ */
+void EXTI_Disable(uint8_t pin);
+
+/**
+ * @brief Changes the trigger edges of an attached line.
+ */
+void EXTI_SetEdge(uint8_t pin, EXTIEdge edge);
+
+/**
+ * @brief Returns the attached lines as a bit mask.
+ * Note:
+ *  Pass to Clock_ConfigureWakeup so the same lines wake the core from Stop.
+ */
+uint16_t EXTI_GetLines(void);
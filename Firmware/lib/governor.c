@@ -0,0 +1,143 @@
+/**
+ * @file    governor.c
+ * @brief   Dynamic frequency scaling driven by audio buffer pressure
+ * @author  Joshua
+ * @date    2025-11-02
+ */
+
+#include "governor.h"
+#include "spibus.h"
+
+// Operating point of each level, buses undivided so HCLK follows SYSCLK
+static const ClockProfileConfig levels[GOVERNOR_LEVEL_COUNT] = {
+    [GOVERNOR_LEVEL_IDLE] =
+        {.source = SYSCLK_SRC_HSISYS, .hsi_div = CLOCK_DIV_BY_16, .bus = {.ahb_div = 1, .apb1_div = 1, .apb2_div = 1}},
+    [GOVERNOR_LEVEL_ECONOMY] =
+        {.source = SYSCLK_SRC_HSISYS, .hsi_div = CLOCK_DIV_BY_4, .bus = {.ahb_div = 1, .apb1_div = 1, .apb2_div = 1}},
+    [GOVERNOR_LEVEL_NORMAL] =
+        {.source = SYSCLK_SRC_HSISYS, .hsi_div = CLOCK_DIV_BY_1, .bus = {.ahb_div = 1, .apb1_div = 1, .apb2_div = 1}},
+    // 64 MHz PLL plan shared with CLOCK_PROFILE_MAX_THROUGHPUT
+    [GOVERNOR_LEVEL_MAX] =
+        {.source = SYSCLK_SRC_PLLRCLK, .hsi_div = CLOCK_DIV_BY_1, .bus = {.ahb_div = 1, .apb1_div = 1, .apb2_div = 1}},
+};
+
+// HCLK of each level, used to map the running clock in Governor_Init
+static const uint32_t levelFreq[GOVERNOR_LEVEL_COUNT] = {
+    [GOVERNOR_LEVEL_IDLE]    = 1000000UL,
+    [GOVERNOR_LEVEL_ECONOMY] = 4000000UL,
+    [GOVERNOR_LEVEL_NORMAL]  = 16000000UL,
+    [GOVERNOR_LEVEL_MAX]     = 64000000UL,
+};
+
+static GovernorLevel currentLevel = GOVERNOR_LEVEL_NORMAL;
+static GovernorStats stats;
+
+// HCLK summed over every Governor_Update, divided by the update count for the average
+static uint64_t hclkSum = 0;
+
+/**
+ * @brief Picks the level for the given playback state.
+ *
+ * Between the two watermarks the current level is kept, so the clock does not flap around
+ * a single threshold.
+ */
+static GovernorLevel Governor_Decide(const GovernorInput *input) {
+  if (input->sd_burst)
+    return GOVERNOR_LEVEL_MAX;
+
+  if (!input->playing)
+    return GOVERNOR_LEVEL_IDLE;
+
+  if (input->buffer_fill < GOVERNOR_FILL_LOW)
+    return GOVERNOR_LEVEL_MAX;
+
+  if (input->buffer_fill > GOVERNOR_FILL_HIGH)
+    return (input->bitrate_kbps <= GOVERNOR_LOW_BITRATE) ? GOVERNOR_LEVEL_ECONOMY : GOVERNOR_LEVEL_NORMAL;
+
+  // Resuming from pause with a half-full buffer
+  if (currentLevel == GOVERNOR_LEVEL_IDLE)
+    return GOVERNOR_LEVEL_NORMAL;
+
+  return currentLevel;
+}
+
+void Governor_Init(void) {
+  stats   = (GovernorStats){0};
+  hclkSum = 0;
+
+  // Map the running clock onto the closest level
+  uint32_t hclk = Clock_GetHCLK();
+  if (hclk >= levelFreq[GOVERNOR_LEVEL_MAX])
+    currentLevel = GOVERNOR_LEVEL_MAX;
+  else if (hclk >= levelFreq[GOVERNOR_LEVEL_NORMAL])
+    currentLevel = GOVERNOR_LEVEL_NORMAL;
+  else if (hclk >= levelFreq[GOVERNOR_LEVEL_ECONOMY])
+    currentLevel = GOVERNOR_LEVEL_ECONOMY;
+  else
+    currentLevel = GOVERNOR_LEVEL_IDLE;
+}
+
+bool Governor_SetLevel(GovernorLevel level) {
+  if (level >= GOVERNOR_LEVEL_COUNT)
+    return false;
+
+  if (level == currentLevel)
+    return true;
+
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+
+  // SCK of a running SD or SDI transfer would follow PCLK up to 64x past its limit, try again at
+  // the next update. No transfer can start before the switch is done and the callbacks ran.
+  if (SPIBus_IsActive()) {
+    __set_PRIMASK(primask);
+    stats.deferred_transitions++;
+    return false;
+  }
+
+  // Locks the PLL ahead of the switch and stops it again on the HSI levels, the change
+  // callbacks run in the same critical section as the switch
+  bool ok = Clock_ApplyConfig(&levels[level]);
+
+  __set_PRIMASK(primask);
+
+  if (!ok) {
+    stats.failed_transitions++;
+    return false;
+  }
+
+  currentLevel = level;
+  stats.transitions++;
+  return true;
+}
+
+GovernorLevel Governor_Update(const GovernorInput *input) {
+  if (!input)
+    return currentLevel;
+
+  if (input->playing && input->buffer_fill == 0)
+    stats.underruns++;
+
+  Governor_SetLevel(Governor_Decide(input));
+
+  stats.samples[currentLevel]++;
+  hclkSum += Clock_GetHCLK();
+  return currentLevel;
+}
+
+GovernorLevel Governor_GetLevel(void) {
+  return currentLevel;
+}
+
+const GovernorStats *Governor_GetStats(void) {
+  return &stats;
+}
+
+uint32_t Governor_GetAverageClock(void) {
+  uint32_t total = 0;
+
+  for (uint8_t i = 0; i < GOVERNOR_LEVEL_COUNT; i++)
+    total += stats.samples[i];
+
+  return total ? (uint32_t)(hclkSum / total) : 0;
+}
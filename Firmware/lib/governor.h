@@ -0,0 +1,88 @@
+/**
+ * @file    governor.h
+ * @brief   Dynamic frequency scaling driven by audio buffer pressure
+ * @author  Joshua
+ * @date    2025-11-02
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "clock.h"
+
+#define GOVERNOR_FILL_LOW 25        // Buffer fill (%) below which the core jumps to full speed
+#define GOVERNOR_FILL_HIGH 75       // Buffer fill (%) above which the core may slow down
+#define GOVERNOR_LOW_BITRATE 160    // Bitrate (kbps) considered cheap enough for economy speed
+
+/**
+ * @brief Defines the operating points the governor switches between, HCLK with AHB / 1
+ * Note:
+ *  Drivers follow the transitions through Clock_RegisterChangeCallback.
+ */
+typedef enum {
+  GOVERNOR_LEVEL_IDLE,       // HSI16 / 16 = 1 MHz, paused
+  GOVERNOR_LEVEL_ECONOMY,    // HSI16 / 4 = 4 MHz, low bitrate with a full buffer
+  GOVERNOR_LEVEL_NORMAL,     // HSI16 = 16 MHz
+  GOVERNOR_LEVEL_MAX,        // PLLRCLK = 64 MHz, buffer draining or SD burst
+  GOVERNOR_LEVEL_COUNT
+} GovernorLevel;
+
+/**
+ * @brief Snapshot of the playback state the governor decides on
+ */
+typedef struct {
+  bool playing;              // false when paused or stopped
+  bool sd_burst;             // true while a large SD transfer is pending
+  uint8_t buffer_fill;       // Decoder buffer fill level in percent (0 to 100)
+  uint16_t bitrate_kbps;     // Bitrate of the current stream
+} GovernorInput;
+
+/**
+ * @brief Statistics collected by the governor
+ */
+typedef struct {
+  uint32_t samples[GOVERNOR_LEVEL_COUNT];    // Governor_Update calls spent at each level
+  uint32_t transitions;                      // Successful clock changes
+  uint32_t failed_transitions;               // Clock changes refused by the RCC
+  uint32_t deferred_transitions;             // Clock changes put off while an SPI transfer ran
+  uint32_t underruns;                        // Updates seen with an empty buffer while playing
+} GovernorStats;
+
+/**
+ * @brief Resets the statistics and maps the current HCLK onto the closest level.
+ */
+void Governor_Init(void);
+
+/**
+ * @brief Feeds the current playback state and switches level if needed.
+ * Note:
+ *  Call periodically (e.g. every main loop pass or tick), the statistics count calls.
+ * @return The level the core is running at after the update.
+ */
+GovernorLevel Governor_Update(const GovernorInput *input);
+
+/**
+ * @brief Forces a level, bypassing the decision logic.
+ * Note:
+ *  Refused while an SPI transfer is running (SPIBus_IsActive), Governor_Update simply tries again.
+ * @return true on a successful transition.
+ */
+bool Governor_SetLevel(GovernorLevel level);
+
+/**
+ * @brief Returns the current level.
+ */
+GovernorLevel Governor_GetLevel(void);
+
+/**
+ * @brief Returns the collected statistics.
+ */
+const GovernorStats *Governor_GetStats(void);
+
+/**
+ * @brief Returns the average HCLK over all Governor_Update calls.
+ * @return Frequency in Hz.
+ */
+uint32_t Governor_GetAverageClock(void);
@@ -7,6 +7,37 @@
 
 #include "gpio.h"
 
+// GPIOA, GPIOB, GPIOC, GPIOD and GPIOF
+#define GPIO_PORT_COUNT 5
+
+/**
+ * @brief Accumulated register masks and values of one port
+ */
+typedef struct {
+  uint32_t moder_mask, moder;
+  uint32_t otyper_mask, otyper;
+  uint32_t ospeedr_mask, ospeedr;
+  uint32_t pupdr_mask, pupdr;
+  uint32_t afr_mask[2], afr[2];
+  uint32_t bsrr;
+} GPIOPortConfig;
+
+static GPIO_TypeDef *const ports[GPIO_PORT_COUNT] = {GPIOA, GPIOB, GPIOC, GPIOD, GPIOF};
+
+static const uint32_t portClocks[GPIO_PORT_COUNT] = {
+    RCC_IOPENR_GPIOAEN, RCC_IOPENR_GPIOBEN, RCC_IOPENR_GPIOCEN, RCC_IOPENR_GPIODEN, RCC_IOPENR_GPIOFEN,
+};
+
+/**
+ * @brief Returns the index of a port in ports[], or GPIO_PORT_COUNT if unknown.
+ */
+static uint8_t GPIO_PortIndex(const GPIO_TypeDef *port) {
+  uint8_t i = 0;
+  while (i < GPIO_PORT_COUNT && ports[i] != port)
+    i++;
+  return i;
+}
+
 void GPIO_EnablePort(GPIO_TypeDef *port) {
   if (port == GPIOA)
     RCC->IOPENR |= RCC_IOPENR_GPIOAEN;
@@ -40,12 +71,81 @@ void GPIO_EnablePin(GPIO_TypeDef *port, uint8_t pin, GPIOOType otype, GPIOMode m
   port->PUPDR |= (pull << (pin << 1));
 }
 
+void GPIO_ConfigurePort(const GPIOPinConfig *table, uint8_t count) {
+  GPIOPortConfig cfg[GPIO_PORT_COUNT] = {0};
+  uint32_t clocks                     = 0;
+
+  for (uint8_t i = 0; i < count; i++) {
+    const GPIOPinConfig *p = &table[i];
+    uint8_t index          = GPIO_PortIndex(p->port);
+    if (index >= GPIO_PORT_COUNT || p->pin > 15)
+      continue;
+
+    GPIOPortConfig *c = &cfg[index];
+    uint8_t shift2    = p->pin << 1;
+    uint8_t shift4    = (p->pin & 7) << 2;
+    uint8_t afr       = p->pin >> 3;
+
+    c->moder_mask |= 0x3UL << shift2;
+    c->moder |= (uint32_t)p->mode << shift2;
+    c->otyper_mask |= 1UL << p->pin;
+    c->otyper |= (uint32_t)p->otype << p->pin;
+    c->ospeedr_mask |= 0x3UL << shift2;
+    c->ospeedr |= (uint32_t)p->speed << shift2;
+    c->pupdr_mask |= 0x3UL << shift2;
+    c->pupdr |= (uint32_t)p->pull << shift2;
+
+    if (p->mode == GPIO_MODE_AF) {
+      c->afr_mask[afr] |= 0xFUL << shift4;
+      c->afr[afr] |= (uint32_t)(p->af & 0xF) << shift4;
+    }
+
+    if (p->mode == GPIO_MODE_OUTPUT)
+      c->bsrr |= (1UL << p->pin) << (p->level ? 0 : 16);
+
+    clocks |= portClocks[index];
+  }
+
+  RCC->IOPENR |= clocks;
+
+  for (uint8_t i = 0; i < GPIO_PORT_COUNT; i++) {
+    GPIOPortConfig *c  = &cfg[i];
+    GPIO_TypeDef *port = ports[i];
+    if (!c->moder_mask)
+      continue;
+
+    // Latch the output levels first so chip selects never glitch low when MODER switches
+    if (c->bsrr)
+      port->BSRR = c->bsrr;
+
+    port->OTYPER  = (port->OTYPER & ~c->otyper_mask) | c->otyper;
+    port->OSPEEDR = (port->OSPEEDR & ~c->ospeedr_mask) | c->ospeedr;
+    port->PUPDR   = (port->PUPDR & ~c->pupdr_mask) | c->pupdr;
+
+    if (c->afr_mask[0])
+      port->AFR[0] = (port->AFR[0] & ~c->afr_mask[0]) | c->afr[0];
+    if (c->afr_mask[1])
+      port->AFR[1] = (port->AFR[1] & ~c->afr_mask[1]) | c->afr[1];
+
+    // Mode last, the pin only starts driving once everything else is in place
+    port->MODER = (port->MODER & ~c->moder_mask) | c->moder;
+  }
+}
+
 void GPIO_Write(GPIO_TypeDef *port, uint8_t pin, uint8_t value) {
   port->BSRR = (1 << pin) << (value ? 0 : 16);
 }
 
+void GPIO_WriteMask(GPIO_TypeDef *port, uint16_t set_mask, uint16_t reset_mask) {
+  // BSRR gives set priority when a pin is in both masks
+  port->BSRR = ((uint32_t)reset_mask << 16) | set_mask;
+}
+
 void GPIO_Toggle(GPIO_TypeDef *port, uint8_t pin) {
-  port->ODR ^= (1 << pin);
+  // Single BSRR store, other pins on the port are never written back
+  uint32_t mask = 1UL << pin;
+  uint32_t odr  = port->ODR;
+  port->BSRR    = ((odr & mask) << 16) | (~odr & mask);
 }
 
 uint8_t GPIO_Read(GPIO_TypeDef *port, uint8_t pin) {
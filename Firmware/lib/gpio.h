@@ -47,6 +47,20 @@ typedef enum {
  */
 typedef enum { GPIO_NOPULL, GPIO_PULLUP, GPIO_PULLDOWN } GPIOPull;
 
+/**
+ * @brief One entry of a pin table for GPIO_ConfigurePort
+ */
+typedef struct {
+  GPIO_TypeDef *port;
+  uint8_t pin;
+  GPIOMode mode;
+  GPIOOType otype;
+  GPIOSpeed speed;
+  GPIOPull pull;
+  uint8_t af;       // Alternate function number (0 to 7), only used with GPIO_MODE_AF
+  uint8_t level;    // Output level latched before the pin becomes an output (1 = High)
+} GPIOPinConfig;
+
 /**
  * @brief Enables the clock for a given GPIO port
  */
@@ -57,13 +71,30 @@ void GPIO_EnablePort(GPIO_TypeDef *port);
  */
 void GPIO_EnablePin(GPIO_TypeDef *port, uint8_t pin, GPIOOType otype, GPIOMode mode, GPIOSpeed speed, GPIOPull pull);
 
+/**
+ * @brief Configures a whole pin table, pins may belong to any port
+ * Note:
+ *  All pins of a port are merged, so each port register (ODR levels, MODER, OTYPER, OSPEEDR,
+ *  PUPDR, AFR) is written once, and all port clocks are enabled with a single IOPENR write.
+ */
+void GPIO_ConfigurePort(const GPIOPinConfig *table, uint8_t count);
+
 /**
  * @brief Writes a digital value to a GPIO pin
  */
 void GPIO_Write(GPIO_TypeDef *port, uint8_t pin, uint8_t value);
 
+/**
+ * @brief Sets and clears several pins of one port with a single BSRR write
+ * @param set_mask Pins driven high (bit n = pin n)
+ * @param reset_mask Pins driven low, ignored for pins also in set_mask
+ */
+void GPIO_WriteMask(GPIO_TypeDef *port, uint16_t set_mask, uint16_t reset_mask);
+
 /**
  * @brief Toggle the pin level
+ * Note:
+ *  Atomic against other pins on the same port, an ISR may safely drive them meanwhile.
  */
 void GPIO_Toggle(GPIO_TypeDef *port, uint8_t pin);
 
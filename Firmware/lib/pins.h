@@ -0,0 +1,81 @@
+/**
+ * @file    pins.h
+ * @brief   Compile-time pin descriptors for the music player board
+ * @author  Joshua
+ * @date    2025-11-02
+ *
+ * Every pin of the README pinout gets force-inlined accessors with a constant port and mask,
+ * so chip select edges and DREQ polls are a single BSRR store or IDR load, even when the
+ * project is built without optimization.
+ *
+ * Usage:
+ *   Pin_SD_CS_Low();
+ *   if (Pin_DREQ_Read()) ...
+ *
+ * Use gpio.h to configure the pins, these accessors only drive and sample them.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "stm32g031xx.h"
+
+/**
+ * @brief Board pin table, X(name, port, pin)
+ */
+#define PIN_TABLE(X)         \
+  X(SPI1_SCK, GPIOA, 5)      \
+  X(SPI1_MISO, GPIOA, 6)     \
+  X(SPI1_MOSI, GPIOA, 7)     \
+  X(XDCS, GPIOA, 15)         \
+  X(MP3_CS, GPIOB, 0)        \
+  X(SD_CS, GPIOB, 9)         \
+  X(DREQ, GPIOB, 1)          \
+  X(ENC_R, GPIOA, 1)         \
+  X(ENC_L, GPIOA, 0)         \
+  X(BTN_PLAY, GPIOB, 3)      \
+  X(BTN_NEXT, GPIOB, 5)      \
+  X(BTN_BACK, GPIOB, 4)      \
+  X(OLED_SCL, GPIOB, 6)      \
+  X(OLED_SDA, GPIOB, 7)      \
+  X(LED_PAUSED, GPIOB, 2)    \
+  X(LED_PLAYING, GPIOB, 8)
+
+// Pin numbers and masks, e.g. PIN_SD_CS_NUM and PIN_SD_CS_MASK
+#define PIN_CONSTANTS(name, port, pin) PIN_##name##_NUM = (pin), PIN_##name##_MASK = (1UL << (pin)),
+enum { PIN_TABLE(PIN_CONSTANTS) };
+#undef PIN_CONSTANTS
+
+/**
+ * @brief Accessors generated for each pin
+ *  Pin_<name>_Port()   GPIO port of the pin
+ *  Pin_<name>_High()   Drives the pin high (one BSRR store)
+ *  Pin_<name>_Low()    Drives the pin low (one BSRR store)
+ *  Pin_<name>_Write(v) Drives the pin to v
+ *  Pin_<name>_Toggle() Inverts the pin, atomic against other pins of the port
+ *  Pin_<name>_Read()   Input level (one IDR load), 1 = high
+ */
+#define PIN_ACCESSORS(name, port, pin)                                                                  \
+  __STATIC_FORCEINLINE GPIO_TypeDef *Pin_##name##_Port(void) {                                          \
+    return (port);                                                                                      \
+  }                                                                                                     \
+  __STATIC_FORCEINLINE void Pin_##name##_High(void) {                                                   \
+    (port)->BSRR = (1UL << (pin));                                                                      \
+  }                                                                                                     \
+  __STATIC_FORCEINLINE void Pin_##name##_Low(void) {                                                    \
+    (port)->BSRR = (1UL << (pin)) << 16;                                                                \
+  }                                                                                                     \
+  __STATIC_FORCEINLINE void Pin_##name##_Write(uint8_t value) {                                         \
+    (port)->BSRR = (1UL << (pin)) << (value ? 0 : 16);                                                  \
+  }                                                                                                     \
+  __STATIC_FORCEINLINE void Pin_##name##_Toggle(void) {                                                 \
+    uint32_t odr = (port)->ODR;                                                                         \
+    (port)->BSRR = ((odr & (1UL << (pin))) << 16) | (~odr & (1UL << (pin)));                            \
+  }                                                                                                     \
+  __STATIC_FORCEINLINE uint8_t Pin_##name##_Read(void) {                                                \
+    return ((port)->IDR >> (pin)) & 1;                                                                  \
+  }
+
+PIN_TABLE(PIN_ACCESSORS)
+#undef PIN_ACCESSORS
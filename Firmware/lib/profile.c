@@ -0,0 +1,83 @@
+/**
+ * @file    profile.c
+ * @brief   Free-running microsecond timestamp for hot-path profiling
+ * @author  Joshua
+ * @date    2025-11-02
+ */
+
+#include "profile.h"
+#include "clock.h"
+
+#if PROFILE_USE_TIM2
+#define PROFILE_TIM TIM2
+#else
+#define PROFILE_TIM TIM3
+volatile uint16_t profileHigh = 0;
+#endif
+
+/**
+ * @brief Returns the prescaler for a 1 MHz count from the current timer kernel clock.
+ */
+static uint32_t Profile_GetPrescaler(const ClockTree *tree) {
+  // Timers run at twice PCLK when the APB prescaler is not 1
+  uint32_t timclk = (tree->pclk == tree->hclk) ? tree->pclk : (tree->pclk << 1);
+
+  return (timclk >= 1000000UL) ? (timclk / 1000000UL) - 1 : 0;
+}
+
+/**
+ * @brief Clock change hook, reloads the prescaler without losing the count.
+ */
+static void Profile_OnClockChange(const ClockTree *tree) {
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+
+  // PSC is preloaded, force the update and put the counter back
+  uint32_t count   = PROFILE_TIM->CNT;
+  PROFILE_TIM->PSC = Profile_GetPrescaler(tree);
+  PROFILE_TIM->EGR = TIM_EGR_UG;
+  PROFILE_TIM->CNT = count;
+
+#if !PROFILE_USE_TIM2
+  // The forced update is not an overflow
+  PROFILE_TIM->SR = (uint32_t)~TIM_SR_UIF;
+#endif
+
+  __set_PRIMASK(primask);
+}
+
+void Profile_Init(void) {
+#if PROFILE_USE_TIM2
+  RCC->APBENR1 |= RCC_APBENR1_TIM2EN;
+  PROFILE_TIM->ARR = 0xFFFFFFFFUL;
+#else
+  RCC->APBENR1 |= RCC_APBENR1_TIM3EN;
+  PROFILE_TIM->ARR = 0xFFFF;
+  profileHigh      = 0;
+#endif
+
+  PROFILE_TIM->CR1 = 0;
+  PROFILE_TIM->PSC = Profile_GetPrescaler(Clock_GetTree());
+  PROFILE_TIM->CNT = 0;
+  PROFILE_TIM->EGR = TIM_EGR_UG;
+  PROFILE_TIM->SR  = 0;
+
+#if !PROFILE_USE_TIM2
+  PROFILE_TIM->DIER = TIM_DIER_UIE;
+  NVIC_SetPriority(TIM3_IRQn, 0);
+  NVIC_EnableIRQ(TIM3_IRQn);
+#endif
+
+  PROFILE_TIM->CR1 = TIM_CR1_CEN;
+
+  Clock_RegisterChangeCallback(Profile_OnClockChange);
+}
+
+#if !PROFILE_USE_TIM2
+void TIM3_IRQHandler(void) {
+  if (TIM3->SR & TIM_SR_UIF) {
+    TIM3->SR = (uint32_t)~TIM_SR_UIF;
+    profileHigh++;
+  }
+}
+#endif
@@ -0,0 +1,70 @@
+/**
+ * @file    profile.h
+ * @brief   Free-running microsecond timestamp for hot-path profiling
+ * @author  Joshua
+ * @date    2025-11-02
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "stm32g031xx.h"
+
+/**
+ * @brief Selects the timestamp timer.
+ * 1: TIM2 in 32-bit mode (encoder not on TIM2).
+ * 0: TIM3 at 16 bits, upper half extended in software from the update interrupt.
+ */
+#ifndef PROFILE_USE_TIM2
+#define PROFILE_USE_TIM2 1
+#endif
+
+#if !PROFILE_USE_TIM2
+// Upper 16 bits of the TIM3 timestamp, advanced by TIM3_IRQHandler
+extern volatile uint16_t profileHigh;
+#endif
+
+/**
+ * @brief Starts the 1 MHz free-running counter and follows later clock changes.
+ * Note:
+ *  Below 1 MHz timer clock (LSI / LSE SYSCLK) the counter runs at the timer clock instead.
+ */
+void Profile_Init(void);
+
+/**
+ * @brief Returns the current timestamp in microseconds, wraps after ~71 minutes.
+ * Note:
+ *  Lock-free, safe from any ISR or the main loop.
+ */
+static inline uint32_t Profile_Now(void) {
+#if PROFILE_USE_TIM2
+  return TIM2->CNT;
+#else
+  uint16_t high;
+  uint16_t low;
+  uint32_t pending;
+
+  // Retry if the update interrupt ran in between
+  do {
+    high    = profileHigh;
+    low     = (uint16_t)TIM3->CNT;
+    pending = TIM3->SR & TIM_SR_UIF;
+  } while (high != profileHigh);
+
+  // Overflow not yet handled (e.g. called from a higher priority ISR), a large low half
+  // means the overflow came after the counter was read
+  if (pending && low < 0x8000)
+    high++;
+
+  return ((uint32_t)high << 16) | low;
+#endif
+}
+
+/**
+ * @brief Returns the microseconds elapsed since @p start, wrap safe.
+ */
+static inline uint32_t Profile_Elapsed(uint32_t start) {
+  return Profile_Now() - start;
+}
@@ -0,0 +1,324 @@
+/**
+ * @file    spi.c
+ * @brief   DMA driven SPI1 master driver for STM32G031K8T6
+ * @author  Joshua
+ * @date    2025-11-02
+ */
+
+#include "spi.h"
+
+#define SPI_TIMEOUT 10000    // Max. iterations to wait for the FIFOs to drain
+
+// DMAMUX request lines (RM0444, DMAMUX mapping)
+#define DMAMUX_REQ_SPI1_RX 16
+#define DMAMUX_REQ_SPI1_TX 17
+
+// DMA1 channel 2 = RX, channel 3 = TX, DMAMUX channel n serves DMA channel n + 1
+#define SPI_DMA_RX DMA1_Channel2
+#define SPI_DMA_TX DMA1_Channel3
+#define SPI_DMAMUX_RX DMAMUX1_Channel1
+#define SPI_DMAMUX_TX DMAMUX1_Channel2
+
+// Byte and half-word access to the data register, the access size sets how many frames move.
+// The host tests include this file with their own versions to follow every access.
+#ifndef SPI_READ_DR8
+#define SPI_READ_DR8() (*(volatile uint8_t *)&SPI1->DR)
+#define SPI_READ_DR16() (*(volatile uint16_t *)&SPI1->DR)
+#define SPI_WRITE_DR8(data) (*(volatile uint8_t *)&SPI1->DR = (data))
+#define SPI_WRITE_DR16(data) (*(volatile uint16_t *)&SPI1->DR = (data))
+#endif
+
+static volatile bool busy = false;
+static uint8_t frameBits  = 8;
+static SPICallback doneCallback;
+static void *doneArg;
+
+/**
+ * @brief State of a programmed I/O (polled or interrupt) transfer
+ *
+ * The counts are frames. With frames of 8 bits or less, two frames move per half-word DR access
+ * (FIFO data packing), larger frames move one per access.
+ */
+static struct {
+  const uint8_t *tx;    // NULL sends SPI_DUMMY_FRAME
+  uint8_t *rx;          // NULL discards
+  uint16_t txLeft;
+  uint16_t rxLeft;
+} pio;
+
+// Source of dummy bytes for receive-only, sink of discarded bytes for transmit-only
+static const uint16_t dummyTx = SPI_DUMMY_FRAME;
+static uint16_t dummyRx;
+
+/**
+ * @brief Starts both DMA channels for one transfer.
+ *
+ * RX always runs, even when the data is discarded: its transfer complete means the last byte
+ * has been shifted in, so the callback may release the chip select immediately, and the RX
+ * FIFO can never overrun.
+ */
+static bool SPI_Start(const uint8_t *tx, bool tx_inc, uint8_t *rx, bool rx_inc, uint16_t len,
+                      SPICallback callback, void *arg) {
+  if (!len)
+    return false;
+
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  if (busy) {
+    __set_PRIMASK(primask);
+    return false;
+  }
+  busy = true;
+  __set_PRIMASK(primask);
+
+  doneCallback = callback;
+  doneArg      = arg;
+
+  DMA1->IFCR = DMA_IFCR_CGIF2 | DMA_IFCR_CGIF3;
+
+  // Frames above 8 bits are moved as half-words on both sides
+  uint32_t size = (frameBits > 8) ? (DMA_CCR_PSIZE_0 | DMA_CCR_MSIZE_0) : 0;
+
+  // RX: peripheral to memory, higher priority than TX so the FIFO is drained first
+  SPI_DMA_RX->CNDTR = len;
+  SPI_DMA_RX->CMAR  = (uint32_t)rx;
+  SPI_DMA_RX->CCR   = DMA_CCR_PL_1 | size | (rx_inc ? DMA_CCR_MINC : 0) | DMA_CCR_TCIE | DMA_CCR_TEIE;
+
+  // TX: memory to peripheral, errors only, completion is signalled by RX
+  SPI_DMA_TX->CNDTR = len;
+  SPI_DMA_TX->CMAR  = (uint32_t)tx;
+  SPI_DMA_TX->CCR   = DMA_CCR_DIR | size | (tx_inc ? DMA_CCR_MINC : 0) | DMA_CCR_TEIE;
+
+  // Order from the reference manual: RXDMAEN, channels, TXDMAEN
+  SPI1->CR2 |= SPI_CR2_RXDMAEN;
+  SPI_DMA_RX->CCR |= DMA_CCR_EN;
+  SPI_DMA_TX->CCR |= DMA_CCR_EN;
+  SPI1->CR2 |= SPI_CR2_TXDMAEN;
+  return true;
+}
+
+/**
+ * @brief Moves as many frames as the FIFOs allow, without blocking.
+ *
+ * At most 4 bytes are ever in flight, so the 32-bit RX FIFO cannot overrun even if this runs late.
+ * @return true once every frame has been received.
+ */
+static bool SPI_Pump(void) {
+  bool wide = frameBits > 8;
+
+  // RX first, it makes room for TX
+  while (pio.rxLeft && (SPI1->SR & SPI_SR_RXNE)) {
+    if (wide || !(SPI1->CR2 & SPI_CR2_FRXTH)) {
+      uint16_t data = SPI_READ_DR16();
+      if (pio.rx) {
+        pio.rx[0] = (uint8_t)data;
+        pio.rx[1] = (uint8_t)(data >> 8);
+        pio.rx += 2;
+      }
+      pio.rxLeft -= wide ? 1 : 2;
+    } else {
+      uint8_t data = SPI_READ_DR8();
+      if (pio.rx)
+        *pio.rx++ = data;
+      pio.rxLeft--;
+    }
+
+    // A single trailing byte never reaches the half-word threshold
+    if (!wide && pio.rxLeft == 1)
+      SPI1->CR2 |= SPI_CR2_FRXTH;
+  }
+
+  // Frames sent but not yet received, in bytes
+  while (pio.txLeft && (SPI1->SR & SPI_SR_TXE)) {
+    uint16_t inflight = (uint16_t)((pio.rxLeft - pio.txLeft) * (wide ? 2 : 1));
+    if (inflight > 2)
+      break;
+
+    if (wide || pio.txLeft >= 2) {
+      uint16_t data = SPI_DUMMY_FRAME;
+      if (pio.tx) {
+        data = (uint16_t)(pio.tx[0] | (pio.tx[1] << 8));
+        pio.tx += 2;
+      }
+      SPI_WRITE_DR16(data);
+      pio.txLeft -= wide ? 1 : 2;
+    } else {
+      SPI_WRITE_DR8(pio.tx ? *pio.tx++ : (uint8_t)SPI_DUMMY_FRAME);
+      pio.txLeft--;
+    }
+  }
+
+  return pio.rxLeft == 0;
+}
+
+/**
+ * @brief Claims the bus and loads the programmed I/O state.
+ */
+static bool SPI_StartPIO(const uint8_t *tx, uint8_t *rx, uint16_t len) {
+  if (!len)
+    return false;
+
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  if (busy) {
+    __set_PRIMASK(primask);
+    return false;
+  }
+  busy = true;
+  __set_PRIMASK(primask);
+
+  pio.tx     = tx;
+  pio.rx     = rx;
+  pio.txLeft = len;
+  pio.rxLeft = len;
+
+  // Half-word RX threshold while pairs of bytes are expected
+  if (frameBits > 8 || len >= 2)
+    SPI1->CR2 &= ~SPI_CR2_FRXTH;
+  else
+    SPI1->CR2 |= SPI_CR2_FRXTH;
+
+  return true;
+}
+
+/**
+ * @brief Restores the byte threshold the DMA path relies on.
+ */
+static void SPI_StopPIO(void) {
+  SPI1->CR2 &= ~SPI_CR2_RXNEIE;
+  if (frameBits <= 8)
+    SPI1->CR2 |= SPI_CR2_FRXTH;
+  busy = false;
+}
+
+void SPI_Init(SPIBaud baud, SPIMode mode) {
+  RCC->APBENR2 |= RCC_APBENR2_SPI1EN;
+  RCC->AHBENR |= RCC_AHBENR_DMA1EN;
+
+  SPI1->CR1 = 0;
+
+  // 8-bit frames, RXNE at one byte
+  SPI1->CR2 = (7UL << SPI_CR2_DS_Pos) | SPI_CR2_FRXTH;
+
+  // Master, software NSS held high
+  SPI1->CR1 = SPI_CR1_MSTR | SPI_CR1_SSM | SPI_CR1_SSI | ((uint32_t)baud << SPI_CR1_BR_Pos) |
+              ((uint32_t)mode & (SPI_CR1_CPOL | SPI_CR1_CPHA));
+  SPI1->CR1 |= SPI_CR1_SPE;
+
+  // Request routing and fixed peripheral addresses, only memory side changes per transfer
+  SPI_DMAMUX_RX->CCR = DMAMUX_REQ_SPI1_RX;
+  SPI_DMAMUX_TX->CCR = DMAMUX_REQ_SPI1_TX;
+  SPI_DMA_RX->CPAR   = (uint32_t)&SPI1->DR;
+  SPI_DMA_TX->CPAR   = (uint32_t)&SPI1->DR;
+
+  busy      = false;
+  frameBits = 8;
+  NVIC_EnableIRQ(DMA1_Channel2_3_IRQn);
+  NVIC_EnableIRQ(SPI1_IRQn);
+}
+
+bool SPI_SetFormat(SPIBaud baud, SPIMode mode, uint8_t bits) {
+  if (busy || bits < 4 || bits > 16)
+    return false;
+
+  // BR, CPOL/CPHA and DS may only change while SPE is cleared
+  SPI1->CR1 &= ~SPI_CR1_SPE;
+  SPI1->CR1 = (SPI1->CR1 & ~(SPI_CR1_BR | SPI_CR1_CPOL | SPI_CR1_CPHA)) | ((uint32_t)baud << SPI_CR1_BR_Pos) |
+              ((uint32_t)mode & (SPI_CR1_CPOL | SPI_CR1_CPHA));
+
+  // RXNE at one byte for small frames, at a half-word otherwise
+  SPI1->CR2 = (SPI1->CR2 & ~(SPI_CR2_DS | SPI_CR2_FRXTH)) | ((uint32_t)(bits - 1) << SPI_CR2_DS_Pos) |
+              ((bits <= 8) ? SPI_CR2_FRXTH : 0);
+  frameBits = bits;
+
+  SPI1->CR1 |= SPI_CR1_SPE;
+  return true;
+}
+
+bool SPI_Transmit(const uint8_t *tx, uint16_t len, SPICallback callback, void *arg) {
+  return SPI_Start(tx, true, (uint8_t *)&dummyRx, false, len, callback, arg);
+}
+
+bool SPI_Receive(uint8_t *rx, uint16_t len, SPICallback callback, void *arg) {
+  return SPI_Start((const uint8_t *)&dummyTx, false, rx, true, len, callback, arg);
+}
+
+bool SPI_TransmitReceive(const uint8_t *tx, uint8_t *rx, uint16_t len, SPICallback callback, void *arg) {
+  return SPI_Start(tx, true, rx, true, len, callback, arg);
+}
+
+bool SPI_TransferPolled(const uint8_t *tx, uint8_t *rx, uint16_t len) {
+  if (!SPI_StartPIO(tx, rx, len))
+    return false;
+
+  // The timeout restarts whenever a frame comes in, so slow SCK settings are fine
+  uint32_t timeout = 0;
+  uint16_t left    = pio.rxLeft;
+  while (!SPI_Pump() && (timeout++ < SPI_TIMEOUT)) {
+    if (pio.rxLeft != left) {
+      left    = pio.rxLeft;
+      timeout = 0;
+    }
+  }
+
+  bool ok = pio.rxLeft == 0;
+  SPI_StopPIO();
+  return ok;
+}
+
+bool SPI_TransferIT(const uint8_t *tx, uint8_t *rx, uint16_t len, SPICallback callback, void *arg) {
+  if (!SPI_StartPIO(tx, rx, len))
+    return false;
+
+  doneCallback = callback;
+  doneArg      = arg;
+
+  // Prime the TX FIFO, from then on every RXNE refills it, no TXE interrupt storm while throttled
+  SPI_Pump();
+  SPI1->CR2 |= SPI_CR2_RXNEIE;
+  return true;
+}
+
+bool SPI_IsBusy(void) {
+  return busy;
+}
+
+void DMA1_Channel2_3_IRQHandler(void) {
+  uint32_t isr = DMA1->ISR;
+
+  if (!(isr & (DMA_ISR_TCIF2 | DMA_ISR_TEIF2 | DMA_ISR_TEIF3)))
+    return;
+
+  DMA1->IFCR = DMA_IFCR_CGIF2 | DMA_IFCR_CGIF3;
+
+  SPI_DMA_TX->CCR &= ~DMA_CCR_EN;
+  SPI_DMA_RX->CCR &= ~DMA_CCR_EN;
+  SPI1->CR2 &= ~(SPI_CR2_TXDMAEN | SPI_CR2_RXDMAEN);
+
+  bool ok = !(isr & (DMA_ISR_TEIF2 | DMA_ISR_TEIF3));
+
+  // After an error bytes may be left behind, drain them and clear a possible overrun
+  if (!ok) {
+    uint32_t timeout = 0;
+    while ((SPI1->SR & (SPI_SR_FTLVL | SPI_SR_BSY)) && (timeout++ < SPI_TIMEOUT))
+      ;
+    while (SPI1->SR & SPI_SR_FRLVL)
+      (void)SPI1->DR;
+    (void)SPI1->SR;
+  }
+
+  busy = false;
+
+  if (doneCallback)
+    doneCallback(ok, doneArg);
+}
+
+void SPI1_IRQHandler(void) {
+  if (!SPI_Pump())
+    return;
+
+  SPI_StopPIO();
+
+  if (doneCallback)
+    doneCallback(true, doneArg);
+}
@@ -0,0 +1,121 @@
+/**
+ * @file    spi.h
+ * @brief   DMA driven SPI1 master driver for STM32G031K8T6
+ * @author  Joshua
+ * @date    2025-11-02
+ *
+ * SPI1 (PA5 SCK, PA6 MISO, PA7 MOSI) is shared by the VS1053B and the SD card. Transfers run on
+ * DMA1 channel 2 (RX) and channel 3 (TX), routed through DMAMUX, and complete in
+ * DMA1_Channel2_3_IRQHandler. The pins are configured by the board pin table, chip selects are
+ * driven by the caller.
+ *
+ * Sustained DMA throughput at PCLK 64 MHz, back-to-back bursts, in kB/s. Computed by
+ * test/bench_spi.c from the wire time plus about 96 cycles of setup and completion interrupt per
+ * burst (register accesses counted, 4 cycles each, 32 cycles exception entry and exit); not
+ * measured on the board, and the SPIBus queue and chip select come on top:
+ *
+ *   SCK        wire   32-byte SDI   512-byte sector
+ *   PCLK/2     4000          3368              3953
+ *   PCLK/4     2000          1828              1988
+ *   PCLK/8     1000           955               997
+ *   PCLK/16     500           488               499
+ *   PCLK/32     250           247               249
+ *   PCLK/64     125           124               124
+ *   PCLK/128     62            62                62
+ *   PCLK/256     31            31                31
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "stm32g031xx.h"
+
+#define SPI_DUMMY_FRAME 0xFFFF    // Clocked out on MOSI during receive-only transfers
+#define SPI_DMA_MIN_LEN 16        // Shorter transfers are cheaper with SPI_TransferIT than with DMA setup
+
+/**
+ * @brief SCK = PCLK / divider
+ */
+typedef enum {
+  SPI_BAUD_DIV_2,
+  SPI_BAUD_DIV_4,
+  SPI_BAUD_DIV_8,
+  SPI_BAUD_DIV_16,
+  SPI_BAUD_DIV_32,
+  SPI_BAUD_DIV_64,
+  SPI_BAUD_DIV_128,
+  SPI_BAUD_DIV_256
+} SPIBaud;
+
+/**
+ * @brief Clock polarity and phase, (CPOL << 1) | CPHA
+ */
+typedef enum {
+  SPI_MODE_0,    // CPOL 0, CPHA 0 (SD card, VS1053B)
+  SPI_MODE_1,
+  SPI_MODE_2,
+  SPI_MODE_3
+} SPIMode;
+
+/**
+ * @brief Called from the DMA interrupt once the last byte has been clocked in.
+ * @param ok false if the DMA reported a transfer error.
+ */
+typedef void (*SPICallback)(bool ok, void *arg);
+
+/**
+ * @brief Enables SPI1 and DMA1, and configures SPI1 as 8-bit master.
+ * Note:
+ *  Transfer lengths count frames, which are bytes unless SPI_SetFormat selects more than 8 bits.
+ */
+void SPI_Init(SPIBaud baud, SPIMode mode);
+
+/**
+ * @brief Changes the SCK divider, mode and frame size between transfers.
+ * @param bits Frame size, 4 to 16. Above 8 bits, buffers hold uint16_t frames and lengths count frames.
+ * @return false while a transfer is in flight or on an invalid frame size.
+ */
+bool SPI_SetFormat(SPIBaud baud, SPIMode mode, uint8_t bits);
+
+/**
+ * @brief Sends @p len frames, received data is discarded (VS1053 SDI, SD writes).
+ * @return false if busy or @p len is 0.
+ */
+bool SPI_Transmit(const uint8_t *tx, uint16_t len, SPICallback callback, void *arg);
+
+/**
+ * @brief Receives @p len frames while clocking out SPI_DUMMY_FRAME (SD reads).
+ * @return false if busy or @p len is 0.
+ */
+bool SPI_Receive(uint8_t *rx, uint16_t len, SPICallback callback, void *arg);
+
+/**
+ * @brief Sends @p tx and receives into @p rx at the same time. The buffers may be the same.
+ * @return false if busy or @p len is 0.
+ */
+bool SPI_TransmitReceive(const uint8_t *tx, uint8_t *rx, uint16_t len, SPICallback callback, void *arg);
+
+/**
+ * @brief Exchanges @p len frames by polling the FIFO, returns when done.
+ * Note:
+ *  Frames of 8 bits or less are packed two per half-word DR access. tx NULL sends
+ *  SPI_DUMMY_FRAME, rx NULL discards the received data.
+ * @return false if busy, @p len is 0 or the SPI stalled.
+ */
+bool SPI_TransferPolled(const uint8_t *tx, uint8_t *rx, uint16_t len);
+
+/**
+ * @brief Exchanges @p len frames from SPI1_IRQHandler, driven by the RX FIFO level interrupt.
+ * Note:
+ *  Meant for short transfers (below SPI_DMA_MIN_LEN), same packing and NULL rules as
+ *  SPI_TransferPolled. The callback runs from the SPI interrupt.
+ * @return false if busy or @p len is 0.
+ */
+bool SPI_TransferIT(const uint8_t *tx, uint8_t *rx, uint16_t len, SPICallback callback, void *arg);
+
+/**
+ * @brief Checks if a transfer is in flight.
+ */
+bool SPI_IsBusy(void);
@@ -0,0 +1,302 @@
+/**
+ * @file    spibus.c
+ * @brief   Arbiter for the SPI1 bus shared by the SD card and the VS1053B
+ * @author  Joshua
+ * @date    2025-11-02
+ */
+
+#include "spibus.h"
+#include "clock.h"
+#include "pins.h"
+
+#include <stddef.h>
+
+// Marks "no device", for the configured device and the bus owner
+#define SPIBUS_NONE SPIBUS_DEVICE_COUNT
+
+/**
+ * @brief FIFO of transfers, tail points at the last next link
+ */
+typedef struct {
+  SPIBusTransfer *head;
+  SPIBusTransfer **tail;
+} SPIBusQueue;
+
+static SPIBusProfile profiles[SPIBUS_DEVICE_COUNT];
+static SPIBusQueue urgent;
+static SPIBusQueue normal;
+static SPIBusTransfer *active = NULL;
+
+// Device SPI1 is currently programmed for, SPIBUS_NONE forces a rewrite
+static SPIBusDevice configured = SPIBUS_NONE;
+
+// Device holding CS across transfers (SPIBUS_FLAG_HOLD)
+static SPIBusDevice owner = SPIBUS_NONE;
+
+static SPIBusStats stats;
+
+/**
+ * @brief Appends a transfer to a queue.
+ */
+static void SPIBus_Enqueue(SPIBusQueue *queue, SPIBusTransfer *transfer) {
+  transfer->next = NULL;
+  *queue->tail   = transfer;
+  queue->tail    = &transfer->next;
+}
+
+/**
+ * @brief Removes the first transfer of a queue, restricted to one device unless SPIBUS_NONE.
+ * @return The transfer, or NULL if none matches.
+ */
+static SPIBusTransfer *SPIBus_Take(SPIBusQueue *queue, SPIBusDevice device) {
+  SPIBusTransfer **link = &queue->head;
+
+  while (*link && device != SPIBUS_NONE && (*link)->device != device)
+    link = &(*link)->next;
+
+  SPIBusTransfer *transfer = *link;
+  if (!transfer)
+    return NULL;
+
+  *link = transfer->next;
+  if (queue->tail == &transfer->next)
+    queue->tail = link;
+
+  transfer->next = NULL;
+  return transfer;
+}
+
+/**
+ * @brief Checks if a transfer is queued anywhere or running.
+ */
+static bool SPIBus_IsPending(const SPIBusTransfer *transfer) {
+  if (transfer == active)
+    return true;
+
+  for (const SPIBusTransfer *t = urgent.head; t; t = t->next)
+    if (t == transfer)
+      return true;
+  for (const SPIBusTransfer *t = normal.head; t; t = t->next)
+    if (t == transfer)
+      return true;
+
+  return false;
+}
+
+/**
+ * @brief Returns the smallest SCK divider that keeps SCK at or below @p max_hz.
+ */
+static SPIBaud SPIBus_Baud(uint32_t max_hz) {
+  uint32_t pclk = Clock_GetPCLK();
+
+  for (uint8_t br = SPI_BAUD_DIV_2; br < SPI_BAUD_DIV_256; br++)
+    if ((pclk >> (br + 1)) <= max_hz)
+      return (SPIBaud)br;
+
+  return SPI_BAUD_DIV_256;
+}
+
+/**
+ * @brief Drives a device's chip select.
+ */
+static void SPIBus_Select(SPIBusDevice device, bool selected) {
+  const SPIBusProfile *p = &profiles[device];
+  p->cs_port->BSRR       = (uint32_t)p->cs_mask << (selected ? 16 : 0);
+}
+
+/**
+ * @brief SCK follows PCLK, recompute the prescaler at the next transfer.
+ *
+ * The running transfer keeps its prescaler, clock changes must wait for SPIBus_IsActive to clear.
+ */
+static void SPIBus_OnClockChange(const ClockTree *tree) {
+  (void)tree;
+  configured = SPIBUS_NONE;
+}
+
+static void SPIBus_Done(bool ok, void *arg);
+
+/**
+ * @brief Starts the next transfer if the bus is idle. Call with interrupts disabled.
+ */
+static void SPIBus_Next(void) {
+  while (!active) {
+    SPIBusTransfer *transfer = SPIBus_Take(&urgent, owner);
+    if (transfer && normal.head)
+      stats.preemptions++;
+    if (!transfer)
+      transfer = SPIBus_Take(&normal, owner);
+    if (!transfer)
+      return;
+
+    active = transfer;
+
+    const SPIBusProfile *p = &profiles[transfer->device];
+    if (configured != transfer->device) {
+      SPI_SetFormat(SPIBus_Baud(p->max_hz), p->mode, p->bits);
+      configured = transfer->device;
+      stats.reconfigurations++;
+    }
+
+    SPIBus_Select(transfer->device, true);
+
+    // Short transfers skip the DMA setup
+    bool started;
+    if (transfer->len < SPI_DMA_MIN_LEN)
+      started = SPI_TransferIT(transfer->tx, transfer->rx, transfer->len, SPIBus_Done, NULL);
+    else if (!transfer->tx)
+      started = SPI_Receive(transfer->rx, transfer->len, SPIBus_Done, NULL);
+    else if (!transfer->rx)
+      started = SPI_Transmit(transfer->tx, transfer->len, SPIBus_Done, NULL);
+    else
+      started = SPI_TransmitReceive(transfer->tx, transfer->rx, transfer->len, SPIBus_Done, NULL);
+
+    // Only fails if the SPI is used behind the arbiter's back
+    if (!started)
+      SPIBus_Done(false, NULL);
+  }
+}
+
+/**
+ * @brief DMA completion of the active transfer.
+ */
+static void SPIBus_Done(bool ok, void *arg) {
+  (void)arg;
+
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+
+  SPIBusTransfer *transfer = active;
+  active                   = NULL;
+
+  if (!transfer) {
+    __set_PRIMASK(primask);
+    return;
+  }
+
+  if (transfer->flags & SPIBUS_FLAG_HOLD) {
+    owner = transfer->device;
+  } else {
+    SPIBus_Select(transfer->device, false);
+    owner = SPIBUS_NONE;
+  }
+
+  if (ok)
+    stats.transfers++;
+  else
+    stats.errors++;
+
+  __set_PRIMASK(primask);
+
+  // The callback may queue the next step of its sequence before the bus moves on
+  if (transfer->callback)
+    transfer->callback(ok, transfer->arg);
+
+  primask = __get_PRIMASK();
+  __disable_irq();
+  SPIBus_Next();
+  __set_PRIMASK(primask);
+}
+
+void SPIBus_Init(void) {
+  profiles[SPIBUS_DEVICE_SD] = (SPIBusProfile){
+      .max_hz = SPIBUS_SD_INIT_HZ, .mode = SPI_MODE_0, .bits = 8, .cs_port = Pin_SD_CS_Port(), .cs_mask = PIN_SD_CS_MASK};
+
+  // VS1053B: SCI reads up to CLKI/7, SDI up to CLKI/4
+  profiles[SPIBUS_DEVICE_SCI] = (SPIBusProfile){.max_hz  = SPIBUS_VS1053_CLKI / 7,
+                                                .mode    = SPI_MODE_0,
+                                                .bits    = 8,
+                                                .cs_port = Pin_MP3_CS_Port(),
+                                                .cs_mask = PIN_MP3_CS_MASK};
+  profiles[SPIBUS_DEVICE_SDI] = (SPIBusProfile){.max_hz  = SPIBUS_VS1053_CLKI / 4,
+                                                .mode    = SPI_MODE_0,
+                                                .bits    = 8,
+                                                .cs_port = Pin_XDCS_Port(),
+                                                .cs_mask = PIN_XDCS_MASK};
+
+  for (uint8_t i = 0; i < SPIBUS_DEVICE_COUNT; i++)
+    SPIBus_Select((SPIBusDevice)i, false);
+
+  urgent     = (SPIBusQueue){NULL, &urgent.head};
+  normal     = (SPIBusQueue){NULL, &normal.head};
+  active     = NULL;
+  configured = SPIBUS_NONE;
+  owner      = SPIBUS_NONE;
+  stats      = (SPIBusStats){0};
+
+  SPI_Init(SPI_BAUD_DIV_256, SPI_MODE_0);
+  Clock_RegisterChangeCallback(SPIBus_OnClockChange);
+}
+
+void SPIBus_SetSpeed(SPIBusDevice device, uint32_t max_hz) {
+  if (device >= SPIBUS_DEVICE_COUNT || !max_hz)
+    return;
+
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+
+  profiles[device].max_hz = max_hz;
+  if (configured == device)
+    configured = SPIBUS_NONE;
+
+  __set_PRIMASK(primask);
+}
+
+uint32_t SPIBus_GetClock(SPIBusDevice device) {
+  if (device >= SPIBUS_DEVICE_COUNT)
+    return 0;
+
+  return Clock_GetPCLK() >> (SPIBus_Baud(profiles[device].max_hz) + 1);
+}
+
+const SPIBusProfile *SPIBus_GetProfile(SPIBusDevice device) {
+  return (device < SPIBUS_DEVICE_COUNT) ? &profiles[device] : NULL;
+}
+
+bool SPIBus_Submit(SPIBusTransfer *transfer) {
+  if (!transfer || transfer->device >= SPIBUS_DEVICE_COUNT || !transfer->len || (!transfer->tx && !transfer->rx))
+    return false;
+
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+
+  if (SPIBus_IsPending(transfer)) {
+    __set_PRIMASK(primask);
+    stats.errors++;
+    return false;
+  }
+
+  SPIBus_Enqueue((transfer->flags & SPIBUS_FLAG_PRIORITY) ? &urgent : &normal, transfer);
+  SPIBus_Next();
+
+  __set_PRIMASK(primask);
+  return true;
+}
+
+void SPIBus_Release(SPIBusDevice device) {
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+
+  if (active && active->device == device) {
+    // Still running, let its completion raise CS
+    active->flags &= ~SPIBUS_FLAG_HOLD;
+  } else if (owner == device) {
+    owner = SPIBUS_NONE;
+    SPIBus_Select(device, false);
+    SPIBus_Next();
+  }
+
+  __set_PRIMASK(primask);
+}
+
+bool SPIBus_IsBusy(void) {
+  return active || urgent.head || normal.head;
+}
+
+bool SPIBus_IsActive(void) {
+  return active != NULL;
+}
+
+const SPIBusStats *SPIBus_GetStats(void) {
+  return &stats;
+}
@@ -0,0 +1,131 @@
+/**
+ * @file    spibus.h
+ * @brief   Arbiter for the SPI1 bus shared by the SD card and the VS1053B
+ * @author  Joshua
+ * @date    2025-11-02
+ *
+ * Every device has a profile (maximum SCK, mode, frame size, chip select). Transfers are queued
+ * and run one after another on the DMA driver, SPI1 is only reprogrammed when the device changes.
+ * Audio transfers (SPIBUS_FLAG_PRIORITY) go to their own queue, which is always served first,
+ * so a DREQ burst overtakes queued SD metadata reads.
+ *
+ * Usage:
+ *   static SPIBusTransfer xfer = {.device = SPIBUS_DEVICE_SDI, .flags = SPIBUS_FLAG_PRIORITY};
+ *   xfer.tx = chunk; xfer.len = 32; xfer.callback = Done;
+ *   SPIBus_Submit(&xfer);
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "spi.h"
+
+#define SPIBUS_FLAG_PRIORITY 0x01    // Audio feed, served before every normal transfer
+#define SPIBUS_FLAG_HOLD 0x02        // Keep CS low and the bus owned after this transfer
+
+#define SPIBUS_SD_INIT_HZ 400000UL      // SD card identification mode
+#define SPIBUS_VS1053_CLKI 12288000UL   // VS1053B CLKI after reset (XTALI, SC_MULT = 1.0x)
+
+/**
+ * @brief Devices on SPI1
+ */
+typedef enum {
+  SPIBUS_DEVICE_SD,     // SD card, SD_CS (PB9)
+  SPIBUS_DEVICE_SCI,    // VS1053B command port, MP3_CS (PB0)
+  SPIBUS_DEVICE_SDI,    // VS1053B data port, XDCS (PA15)
+  SPIBUS_DEVICE_COUNT
+} SPIBusDevice;
+
+/**
+ * @brief Bus settings of one device
+ */
+typedef struct {
+  uint32_t max_hz;          // Highest SCK the device accepts, the prescaler is derived from PCLK
+  SPIMode mode;
+  uint8_t bits;             // Frame size, 4 to 16
+  GPIO_TypeDef *cs_port;    // Active low chip select
+  uint16_t cs_mask;
+} SPIBusProfile;
+
+/**
+ * @brief One queued transfer, owned by the caller until its callback ran
+ * Note:
+ *  tx NULL = receive only, rx NULL = transmit only.
+ */
+typedef struct SPIBusTransfer {
+  struct SPIBusTransfer *next;    // Queue link, managed by the arbiter
+  SPIBusDevice device;
+  uint8_t flags;                  // SPIBUS_FLAG_*
+  const uint8_t *tx;
+  uint8_t *rx;
+  uint16_t len;                   // Frames, see SPI_SetFormat
+  SPICallback callback;           // Runs from the DMA interrupt after CS has been handled
+  void *arg;
+} SPIBusTransfer;
+
+/**
+ * @brief Statistics collected by the arbiter
+ */
+typedef struct {
+  uint32_t transfers;           // Completed transfers
+  uint32_t reconfigurations;    // SPI1->CR1/CR2 rewrites on a device change
+  uint32_t preemptions;         // Priority transfers started while normal ones were waiting
+  uint32_t errors;              // Transfers that failed or could not be started
+} SPIBusStats;
+
+/**
+ * @brief Initializes SPI1, loads the default profiles and registers for clock changes.
+ * Note:
+ *  Defaults: SD at 400 kHz, SCI at CLKI/7 and SDI at CLKI/4 of the VS1053B after reset.
+ */
+void SPIBus_Init(void);
+
+/**
+ * @brief Changes the maximum SCK of a device, e.g. after SD initialization or VS1053 SCI_CLOCKF.
+ * Note:
+ *  Takes effect at the device's next transfer.
+ */
+void SPIBus_SetSpeed(SPIBusDevice device, uint32_t max_hz);
+
+/**
+ * @brief Returns the SCK a device runs at with the current PCLK.
+ * @return Frequency in Hz.
+ */
+uint32_t SPIBus_GetClock(SPIBusDevice device);
+
+/**
+ * @brief Returns the profile of a device.
+ */
+const SPIBusProfile *SPIBus_GetProfile(SPIBusDevice device);
+
+/**
+ * @brief Queues a transfer and starts it if the bus is free. Safe from interrupts.
+ * @return false on an invalid transfer or if it is already queued.
+ */
+bool SPIBus_Submit(SPIBusTransfer *transfer);
+
+/**
+ * @brief Ends a SPIBUS_FLAG_HOLD sequence: raises CS and lets other devices on the bus.
+ */
+void SPIBus_Release(SPIBusDevice device);
+
+/**
+ * @brief Checks if a transfer is running or queued.
+ */
+bool SPIBus_IsBusy(void);
+
+/**
+ * @brief Checks if a transfer is on the wire right now.
+ * Note:
+ *  SCK follows PCLK and the prescaler of a running transfer cannot change, so a clock change is
+ *  only safe while this is false. Queued transfers pick up the new prescaler when they start.
+ *  Call with interrupts disabled and keep them disabled across the change.
+ */
+bool SPIBus_IsActive(void);
+
+/**
+ * @brief Returns the collected statistics.
+ */
+const SPIBusStats *SPIBus_GetStats(void);
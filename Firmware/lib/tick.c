@@ -0,0 +1,230 @@
+/**
+ * @file    tick.c
+ * @brief   SysTick millisecond timebase for STM32G031K8T6
+ * @author  Joshua
+ * @date    2025-11-02
+ */
+
+#include "tick.h"
+#include "clock.h"
+#include "stm32g031xx.h"
+
+#define TICK_IDLE_MIN_MS 2            // Shorter idles only sleep with WFI
+#define TICK_LPTIM_PRESC 5UL          // LPTIM1 prescaler /32, about 1 ms per count from the LSI
+#define TICK_LPTIM_DIV (1UL << TICK_LPTIM_PRESC)
+#define TICK_LPTIM_MAX 0xFFFEUL       // Largest compare value below ARR
+#define TICK_LPTIM_TIMEOUT 10000UL    // Polls for the LPTIM1 register update flags
+
+static volatile uint32_t ticks = 0;
+
+// Sub-millisecond part of the last Stop, in LPTIM counts * 1000 * TICK_LPTIM_DIV
+static uint32_t idleResidual = 0;
+
+// Partial ticks cut short by a SysTick reload, in 1/TICK_FRACTION_ONE ms
+#define TICK_FRACTION_ONE 0x10000UL
+static uint32_t tickFraction = 0;
+
+/**
+ * @brief Clock change hook, keeps the tick at 1 ms whatever HCLK is.
+ */
+static void Tick_OnClockChange(const ClockTree *tree) {
+  (void)tree;
+  Tick_Reconfigure();
+}
+
+/**
+ * @brief Converts a sleep length into LPTIM1 counts, rounding down so the core never oversleeps.
+ */
+static uint32_t Tick_MsToCounts(uint32_t ms, uint32_t lsi) {
+  uint64_t counts = ((uint64_t)ms * lsi) / (1000UL * TICK_LPTIM_DIV);
+
+  return (counts > TICK_LPTIM_MAX) ? TICK_LPTIM_MAX : (uint32_t)counts;
+}
+
+/**
+ * @brief Converts the LPTIM1 counts spent in Stop back into milliseconds.
+ *
+ * The remainder is carried to the next idle, so repeated short stops do not lose time.
+ */
+static uint32_t Tick_CountsToMs(uint32_t counts, uint32_t lsi) {
+  uint64_t scaled = (uint64_t)counts * 1000UL * TICK_LPTIM_DIV + idleResidual;
+
+  idleResidual = (uint32_t)(scaled % lsi);
+  return (uint32_t)(scaled / lsi);
+}
+
+/**
+ * @brief Waits for an LPTIM1 register update flag and clears it.
+ */
+static bool Tick_WaitLptim(uint32_t flag) {
+  uint32_t timeout = 0;
+  while (!(LPTIM1->ISR & flag) && (timeout++ < TICK_LPTIM_TIMEOUT))
+    ;
+
+  LPTIM1->ICR = flag;
+  return timeout < TICK_LPTIM_TIMEOUT;
+}
+
+/**
+ * @brief Starts LPTIM1 from the LSI with a compare match after @p counts.
+ */
+static bool Tick_StartLptim(uint32_t counts) {
+  RCC->APBENR1 |= RCC_APBENR1_LPTIM1EN;
+  RCC->CCIPR = (RCC->CCIPR & ~RCC_CCIPR_LPTIM1SEL_Msk) | (1UL << RCC_CCIPR_LPTIM1SEL_Pos);    // LSI
+
+  // CFGR and IER can only be written while disabled
+  LPTIM1->CR   = 0;
+  LPTIM1->CFGR = TICK_LPTIM_PRESC << LPTIM_CFGR_PRESC_Pos;
+  LPTIM1->IER  = LPTIM_IER_CMPMIE;
+  LPTIM1->CR   = LPTIM_CR_ENABLE;
+
+  // ARR and CMP can only be written while enabled
+  LPTIM1->ARR = 0xFFFF;
+  if (!Tick_WaitLptim(LPTIM_ISR_ARROK))
+    return false;
+
+  LPTIM1->CMP = counts;
+  if (!Tick_WaitLptim(LPTIM_ISR_CMPOK))
+    return false;
+
+  LPTIM1->ICR = LPTIM_ICR_CMPMCF;
+  NVIC_EnableIRQ(LPTIM1_IRQn);
+  LPTIM1->CR |= LPTIM_CR_CNTSTRT;
+
+  return true;
+}
+
+/**
+ * @brief Reads the LPTIM1 counter, twice since it runs from an asynchronous clock.
+ */
+static uint32_t Tick_ReadLptim(void) {
+  uint32_t a, b;
+
+  do {
+    a = LPTIM1->CNT;
+    b = LPTIM1->CNT;
+  } while (a != b);
+
+  return a;
+}
+
+/**
+ * @brief Stops SysTick and credits the part of the current tick it already counted.
+ *
+ * Clearing VAL restarts the tick from zero, so without this every clock change would drop up to a
+ * millisecond. The fractions add up and become whole ticks.
+ */
+static void Tick_StopSysTick(void) {
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+
+  if (SysTick->CTRL & SysTick_CTRL_ENABLE_Msk) {
+    SysTick->CTRL = 0;
+
+    // A tick is LOAD + 1 counts and ends when VAL reaches 0, so VAL counts of it are still to go.
+    // VAL 0 is a tick just raised or a fresh clear, nothing counted yet either way
+    uint32_t load = SysTick->LOAD;
+    uint32_t val  = SysTick->VAL;
+    uint32_t done = val ? load + 1 - val : 0;
+    tickFraction += (uint32_t)(((uint64_t)done * TICK_FRACTION_ONE) / (load + 1));
+
+    if (tickFraction >= TICK_FRACTION_ONE) {
+      tickFraction -= TICK_FRACTION_ONE;
+      ticks++;
+    }
+  }
+
+  __set_PRIMASK(primask);
+}
+
+void Tick_Init(void) {
+  ticks        = 0;
+  tickFraction = 0;
+
+  Tick_Reconfigure();
+  Clock_RegisterChangeCallback(Tick_OnClockChange);
+
+  NVIC_SetPriority(SysTick_IRQn, 0);
+}
+
+void Tick_Reconfigure(void) {
+  uint32_t reload = Clock_GetHCLK() / TICK_HZ;
+
+  // SysTick reload is 24 bits, at least one count per tick
+  if (reload > SysTick_LOAD_RELOAD_Msk + 1)
+    reload = SysTick_LOAD_RELOAD_Msk + 1;
+  if (reload == 0)
+    reload = 1;
+
+  Tick_StopSysTick();
+  SysTick->LOAD = reload - 1;
+  SysTick->VAL  = 0;
+  SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk | SysTick_CTRL_ENABLE_Msk;
+}
+
+uint32_t Tick_Now(void) {
+  return ticks;
+}
+
+uint32_t Tick_Elapsed(uint32_t start) {
+  return ticks - start;
+}
+
+uint32_t Tick_Deadline(uint32_t ms) {
+  return ticks + ms;
+}
+
+bool Tick_Expired(uint32_t deadline) {
+  return (int32_t)(ticks - deadline) >= 0;
+}
+
+void Tick_Delay(uint32_t ms) {
+  // One extra tick so a partial first tick never shortens the delay
+  uint32_t deadline = Tick_Deadline(ms + 1);
+
+  while (!Tick_Expired(deadline))
+    Clock_EnterSleepMode();
+}
+
+uint32_t Tick_IdleUntil(uint32_t deadline) {
+  uint32_t start    = ticks;
+  int32_t remaining = (int32_t)(deadline - start);
+  uint32_t lsi      = Clock_GetLSI();
+
+  if (remaining <= 0)
+    return 0;
+
+  // Not worth the Stop entry and clock restore, no LSI to time it, or LPTIM1 cannot wake the core
+  uint32_t counts = Tick_MsToCounts((uint32_t)remaining, lsi);
+  if (remaining < TICK_IDLE_MIN_MS || !counts || !Clock_IsReady(CLOCK_BASE_SOURCE_LSI) ||
+      !(Clock_GetWakeup() & CLOCK_WAKE_LPTIM) || !Tick_StartLptim(counts)) {
+    Clock_EnterSleepMode();
+    return ticks - start;
+  }
+
+  // SysTick halts in Stop anyway, keep a pending tick from waking the core at once
+  uint32_t ctrl = SysTick->CTRL;
+  Tick_StopSysTick();
+
+  // false after a real Stop too when the PLL did not relock, the counter is valid either way
+  Clock_EnterStopMode(CLOCK_WAKE_LPTIM);
+
+  // Woken by the compare match or earlier by another source, the counter kept running either way
+  uint32_t elapsed = Tick_ReadLptim();
+  LPTIM1->CR       = 0;
+
+  ticks += Tick_CountsToMs(elapsed, lsi);
+
+  SysTick->VAL  = 0;
+  SysTick->CTRL = ctrl | SysTick_CTRL_ENABLE_Msk;
+
+  return ticks - start;
+}
+
+void LPTIM1_IRQHandler(void) {
+  LPTIM1->ICR = LPTIM_ICR_CMPMCF;
+}
+
+void SysTick_Handler(void) {
+  ticks++;
+}
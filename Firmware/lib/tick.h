@@ -0,0 +1,64 @@
+/**
+ * @file    tick.h
+ * @brief   SysTick millisecond timebase for STM32G031K8T6
+ * @author  Joshua
+ * @date    2025-11-02
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define TICK_HZ 1000UL    // SysTick interrupt rate
+
+/**
+ * @brief Starts the 1 ms SysTick and follows every later clock change.
+ */
+void Tick_Init(void);
+
+/**
+ * @brief Returns the milliseconds since Tick_Init.
+ * Note:
+ *  Wraps after ~49 days, compare times with Tick_Expired / Tick_Elapsed only.
+ */
+uint32_t Tick_Now(void);
+
+/**
+ * @brief Returns the milliseconds elapsed since @p start.
+ */
+uint32_t Tick_Elapsed(uint32_t start);
+
+/**
+ * @brief Returns a deadline @p ms milliseconds from now.
+ */
+uint32_t Tick_Deadline(uint32_t ms);
+
+/**
+ * @brief Checks a deadline without blocking, wrap safe.
+ * @return true once the deadline has passed.
+ */
+bool Tick_Expired(uint32_t deadline);
+
+/**
+ * @brief Blocks for at least @p ms milliseconds, sleeping with WFI between ticks.
+ */
+void Tick_Delay(uint32_t ms);
+
+/**
+ * @brief Idles until @p deadline, in Stop mode with LPTIM1 when it is far enough away.
+ * @return Milliseconds that passed, including the time compensated after Stop.
+ * Note:
+ *  LPTIM1 runs from the LSI (see Clock_MeasureLSI), Stop needs CLOCK_WAKE_LPTIM enabled
+ *  through Clock_ConfigureWakeup, without it the idle falls back to Sleep. Any other wake source
+ *  ends the idle early.
+ */
+uint32_t Tick_IdleUntil(uint32_t deadline);
+
+/**
+ * @brief Reloads SysTick for the current HCLK.
+ * Note:
+ *  Called automatically through Clock_RegisterChangeCallback. The part of the running tick is
+ *  kept, so frequent clock changes do not make Tick_Now fall behind.
+ */
+void Tick_Reconfigure(void);
@@ -0,0 +1,263 @@
+/**
+ * @file    timer.c
+ * @brief   Hierarchical software timer wheel driven by the system tick
+ * @author  Joshua
+ * @date    2025-11-02
+ */
+
+#include "timer.h"
+#include "stm32g031xx.h"
+#include "tick.h"
+
+#include <stddef.h>
+
+// Slot heads, level 0 has 1 ms slots, each level above is 64 times coarser
+static Timer *wheel[TIMER_LEVELS][TIMER_SLOTS];
+
+// Timers whose expiry has been reached, waiting for their callback
+static Timer *expired     = NULL;
+static Timer **expiredEnd = &expired;
+
+// Last tick the wheel was advanced to
+static uint32_t current = 0;
+
+// Armed timers, lets an empty wheel skip straight to the current tick
+static uint32_t armed = 0;
+
+/**
+ * @brief Links a timer at the head of a list.
+ */
+static void Timer_Link(Timer **head, Timer *timer) {
+  timer->next = *head;
+  if (timer->next)
+    timer->next->pprev = &timer->next;
+  timer->pprev = head;
+  *head        = timer;
+}
+
+/**
+ * @brief Unlinks a timer from whatever list holds it.
+ */
+static void Timer_Unlink(Timer *timer) {
+  // Keep the tail pointer valid when the last expired timer is removed
+  if (expiredEnd == &timer->next)
+    expiredEnd = timer->pprev;
+
+  *timer->pprev = timer->next;
+  if (timer->next)
+    timer->next->pprev = timer->pprev;
+  timer->next  = NULL;
+  timer->pprev = NULL;
+}
+
+/**
+ * @brief Puts a timer in the slot matching its distance from the current tick.
+ * @param first Earliest tick the timer may still fire at: current while cascading, since the
+ *  level 0 slot of current is processed right after, current + 1 otherwise.
+ */
+static void Timer_Place(Timer *timer, uint32_t first) {
+  // Only expiries already in the past are pulled forward, one due on first keeps its tick
+  if ((int32_t)(timer->expires - first) < 0)
+    timer->expires = first;
+
+  uint32_t delta = timer->expires - current;
+  uint32_t when  = timer->expires;
+
+  // Too far away for the top level, park it and re-cascade later
+  if (delta > TIMER_MAX_MS)
+    when = current + TIMER_MAX_MS;
+
+  uint8_t level = 0;
+  while (level < TIMER_LEVELS - 1 && (when - current) >= (1UL << ((level + 1) * TIMER_SLOT_BITS)))
+    level++;
+
+  Timer_Link(&wheel[level][(when >> (level * TIMER_SLOT_BITS)) & TIMER_SLOT_MASK], timer);
+}
+
+/**
+ * @brief Re-distributes one slot of a higher level into the levels below.
+ */
+static void Timer_Cascade(uint8_t level) {
+  Timer **head = &wheel[level][(current >> (level * TIMER_SLOT_BITS)) & TIMER_SLOT_MASK];
+  Timer *timer = *head;
+  *head        = NULL;
+
+  while (timer) {
+    Timer *next  = timer->next;
+    timer->pprev = NULL;
+    Timer_Place(timer, current);
+    timer = next;
+  }
+}
+
+/**
+ * @brief Advances the wheel by one tick and moves due timers to the expired list.
+ */
+static void Timer_Advance(void) {
+  current++;
+
+  // Refill the lower levels whenever their index wraps
+  for (uint8_t level = 1; level < TIMER_LEVELS; level++) {
+    if (current & ((1UL << (level * TIMER_SLOT_BITS)) - 1))
+      break;
+    Timer_Cascade(level);
+  }
+
+  Timer **head = &wheel[0][current & TIMER_SLOT_MASK];
+  while (*head) {
+    Timer *timer = *head;
+    Timer_Unlink(timer);
+
+    // Parked timers that are not due yet go back into the wheel
+    if (timer->expires != current) {
+      Timer_Place(timer, current + 1);
+      continue;
+    }
+
+    // Append to keep expiry order within the batch
+    timer->due   = true;
+    timer->next  = NULL;
+    timer->pprev = expiredEnd;
+    *expiredEnd  = timer;
+    expiredEnd   = &timer->next;
+    armed--;
+  }
+}
+
+void Timer_Init(void) {
+  for (uint8_t level = 0; level < TIMER_LEVELS; level++)
+    for (uint8_t slot = 0; slot < TIMER_SLOTS; slot++)
+      wheel[level][slot] = NULL;
+
+  expired    = NULL;
+  expiredEnd = &expired;
+  armed      = 0;
+  current    = Tick_Now();
+}
+
+void Timer_Setup(Timer *timer, TimerCallback callback, void *arg) {
+  timer->next     = NULL;
+  timer->pprev    = NULL;
+  timer->expires  = 0;
+  timer->period   = 0;
+  timer->due      = false;
+  timer->callback = callback;
+  timer->arg      = arg;
+}
+
+void Timer_Start(Timer *timer, uint32_t ms, uint32_t period) {
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+
+  if (timer->pprev)
+    Timer_Stop(timer);
+
+  // An empty wheel stopped following the tick (e.g. during a long tickless idle), catch up like
+  // Timer_Process would so the slot is picked from the same tick the expiry is
+  uint32_t now = Tick_Now();
+  if (!armed)
+    current = now;
+
+  timer->expires = now + ms;
+  timer->period  = period;
+  Timer_Place(timer, current + 1);
+  armed++;
+
+  __set_PRIMASK(primask);
+}
+
+void Timer_Stop(Timer *timer) {
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+
+  if (timer->pprev) {
+    if (!timer->due)
+      armed--;
+
+    Timer_Unlink(timer);
+    timer->due = false;
+  }
+
+  __set_PRIMASK(primask);
+}
+
+bool Timer_IsActive(const Timer *timer) {
+  return timer->pprev != NULL;
+}
+
+void Timer_Process(void) {
+  uint32_t now = Tick_Now();
+  uint32_t primask;
+  bool behind;
+
+  // One tick per critical section, interrupts get a window between ticks of a long catch-up
+  do {
+    primask = __get_PRIMASK();
+    __disable_irq();
+
+    // Nothing armed, no need to walk every tick (e.g. after a long tickless idle)
+    if (!armed)
+      current = now;
+
+    behind = (int32_t)(now - current) > 0;
+    if (behind)
+      Timer_Advance();
+
+    __set_PRIMASK(primask);
+  } while (behind);
+
+  // Run the batch, one timer at a time so callbacks may arm or stop any timer
+  while (1) {
+    primask = __get_PRIMASK();
+    __disable_irq();
+
+    Timer *timer = expired;
+    if (timer) {
+      Timer_Unlink(timer);
+      timer->due = false;
+
+      // Re-arm from the old expiry so a late batch does not accumulate drift
+      if (timer->period) {
+        timer->expires += timer->period;
+        Timer_Place(timer, current + 1);
+        armed++;
+      }
+    }
+
+    __set_PRIMASK(primask);
+
+    if (!timer)
+      break;
+
+    if (timer->callback)
+      timer->callback(timer->arg);
+  }
+}
+
+uint32_t Timer_NextDeadline(void) {
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+
+  uint32_t deadline = current + TIMER_MAX_MS;
+
+  if (expired) {
+    deadline = current;
+  } else {
+    // Nearest non-empty slot of each level, it holds the earliest expiries of that level
+    for (uint8_t level = 0; level < TIMER_LEVELS; level++) {
+      uint32_t shift = level * TIMER_SLOT_BITS;
+      Timer *timer   = NULL;
+
+      for (uint32_t i = 1; i <= TIMER_SLOTS && !timer; i++)
+        timer = wheel[level][((current >> shift) + i) & TIMER_SLOT_MASK];
+
+      // Timer_Process cascades on its way, so only the expiries themselves matter
+      for (; timer; timer = timer->next)
+        if ((int32_t)(timer->expires - deadline) < 0)
+          deadline = timer->expires;
+    }
+  }
+
+  __set_PRIMASK(primask);
+  return deadline;
+}
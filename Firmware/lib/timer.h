@@ -0,0 +1,77 @@
+/**
+ * @file    timer.h
+ * @brief   Hierarchical software timer wheel driven by the system tick
+ * @author  Joshua
+ * @date    2025-11-02
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define TIMER_LEVELS 3                        // Wheel levels
+#define TIMER_SLOT_BITS 6                     // 64 slots per level
+#define TIMER_SLOTS (1UL << TIMER_SLOT_BITS)
+#define TIMER_SLOT_MASK (TIMER_SLOTS - 1)
+#define TIMER_MAX_MS ((1UL << (TIMER_LEVELS * TIMER_SLOT_BITS)) - 1)    // ~262 s, longer timers re-cascade
+
+/**
+ * @brief Called from Timer_Process in the main loop, never from an interrupt
+ */
+typedef void (*TimerCallback)(void *arg);
+
+/**
+ * @brief Timer node, allocated statically by its owner
+ */
+typedef struct Timer {
+  struct Timer *next;        // Next timer in the same slot
+  struct Timer **pprev;      // Link pointing at this timer, NULL when idle
+  uint32_t expires;          // Tick at which the timer fires
+  uint32_t period;           // Re-arm interval in ms, 0 for one-shot
+  bool due;                  // Expired, waiting in the batch for Timer_Process
+  TimerCallback callback;    // Function to run on expiry
+  void *arg;                 // Argument passed to the callback
+} Timer;
+
+/**
+ * @brief Resets the wheel to the current tick. Call after Tick_Init.
+ */
+void Timer_Init(void);
+
+/**
+ * @brief Prepares a timer node. Does not arm it.
+ */
+void Timer_Setup(Timer *timer, TimerCallback callback, void *arg);
+
+/**
+ * @brief Arms (or re-arms) a timer, O(1). Safe from interrupts.
+ * @param ms Delay before the first expiry.
+ * @param period Re-arm interval in ms, 0 for one-shot.
+ */
+void Timer_Start(Timer *timer, uint32_t ms, uint32_t period);
+
+/**
+ * @brief Cancels a timer, O(1). Safe from interrupts.
+ */
+void Timer_Stop(Timer *timer);
+
+/**
+ * @brief Checks if a timer is armed or waiting for its callback.
+ */
+bool Timer_IsActive(const Timer *timer);
+
+/**
+ * @brief Advances the wheel to the current tick and runs all expired callbacks as one batch.
+ * Note:
+ *  Call from the main loop.
+ */
+void Timer_Process(void);
+
+/**
+ * @brief Returns the tick by which Timer_Process must run next.
+ * Note:
+ *  The earliest expiry of all armed timers, at most TIMER_MAX_MS away. Suitable for
+ *  Tick_IdleUntil.
+ */
+uint32_t Timer_NextDeadline(void);
@@ -0,0 +1,533 @@
+/**
+ * @file    vs1053.c
+ * @brief   VS1053B audio decoder driver
+ * @author  Joshua
+ * @date    2025-11-02
+ */
+
+#include "vs1053.h"
+#include "exti.h"
+#include "pins.h"
+#include "profile.h"
+#include "spibus.h"
+#include "tick.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#define VS1053_STREAM_MASK (VS1053_STREAM_SIZE - 1)
+#define VS1053_DREQ_PRIORITY 1    // Below SysTick, above everything else
+
+// SCI opcodes
+#define VS1053_SCI_OP_WRITE 0x02
+#define VS1053_SCI_OP_READ 0x03
+
+// Shadowed registers
+#define VS1053_SHADOW_COUNT 5
+#define VS1053_NO_SHADOW 0xFF
+#define VS1053_SLOT_MODE 0
+#define VS1053_SLOT_BASS 1
+#define VS1053_SLOT_CLOCKF 2
+#define VS1053_SLOT_AUDATA 3
+#define VS1053_SLOT_VOL 4
+
+// Slots the decoder rewrites itself (AUDATA after a stream header), written through the shadow
+// but never answered from it
+#define VS1053_SHADOW_LIVE (1 << VS1053_SLOT_AUDATA)
+
+// SCI_MODE bits the decoder clears once done, commands rather than state
+#define VS1053_SM_SELF_CLEAR (VS1053_SM_RESET | VS1053_SM_CANCEL)
+
+_Static_assert((VS1053_STREAM_SIZE & VS1053_STREAM_MASK) == 0, "VS1053_STREAM_SIZE must be a power of two");
+_Static_assert(VS1053_STREAM_SIZE % VS1053_BURST == 0, "VS1053_STREAM_SIZE must be a multiple of VS1053_BURST");
+
+// Ring buffer, free-running indices, head written by the main loop, tail by the DMA interrupt
+static uint8_t stream[VS1053_STREAM_SIZE];
+static volatile uint16_t head = 0;
+static volatile uint16_t tail = 0;
+
+static volatile bool sending  = false;
+static volatile bool flushing = false;
+
+static SPIBusTransfer burst;
+static VS1053StreamStats streamStats;
+
+// Register of each shadow slot
+static const uint8_t shadowReg[VS1053_SHADOW_COUNT] = {
+    [VS1053_SLOT_MODE] = VS1053_SCI_MODE,     [VS1053_SLOT_BASS] = VS1053_SCI_BASS,
+    [VS1053_SLOT_CLOCKF] = VS1053_SCI_CLOCKF, [VS1053_SLOT_AUDATA] = VS1053_SCI_AUDATA,
+    [VS1053_SLOT_VOL] = VS1053_SCI_VOL,
+};
+
+static uint16_t shadow[VS1053_SHADOW_COUNT];
+static volatile uint8_t shadowValid = 0;    // Bit per slot, value known
+static volatile uint8_t shadowDirty = 0;    // Bit per slot, value not written yet
+
+// One SCI transaction at a time, started from the main loop or the interrupts
+static SPIBusTransfer sci;
+static uint8_t sciTx[2 + 2 * VS1053_SCI_BATCH];
+static uint8_t sciRx[4];
+static volatile bool sciBusy = false;
+static VS1053SCIStats sciStats;
+
+static VS1053BootInfo bootInfo;
+
+static void VS1053_BurstDone(bool ok, void *arg);
+static void VS1053_SCIFlush(void);
+
+/**
+ * @brief Adds the time since @p start to the feeding time, safe against nested interrupts.
+ */
+static void VS1053_AddBusy(uint32_t start) {
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  streamStats.busy_us += Profile_Elapsed(start);
+  __set_PRIMASK(primask);
+}
+
+/**
+ * @brief Starts the next burst if DREQ is high and enough data is buffered.
+ */
+static void VS1053_Feed(void) {
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+
+  if (sending || !Pin_DREQ_Read()) {
+    __set_PRIMASK(primask);
+    return;
+  }
+
+  uint16_t count = head - tail;
+  if (!count) {
+    if (!flushing)
+      streamStats.starvations++;
+    __set_PRIMASK(primask);
+    return;
+  }
+
+  // Full bursts only, a short one is allowed for the end of a file
+  if (count < VS1053_BURST && !flushing) {
+    __set_PRIMASK(primask);
+    return;
+  }
+
+  uint16_t offset = tail & VS1053_STREAM_MASK;
+  uint16_t len    = (count < VS1053_BURST) ? count : VS1053_BURST;
+  if (len > VS1053_STREAM_SIZE - offset)
+    len = VS1053_STREAM_SIZE - offset;
+
+  burst.device   = SPIBUS_DEVICE_SDI;
+  burst.flags    = SPIBUS_FLAG_PRIORITY;
+  burst.tx       = &stream[offset];
+  burst.rx       = NULL;
+  burst.len      = len;
+  burst.callback = VS1053_BurstDone;
+  burst.arg      = NULL;
+
+  sending = true;
+  if (!SPIBus_Submit(&burst))
+    sending = false;
+
+  __set_PRIMASK(primask);
+}
+
+/**
+ * @brief SDI burst finished, chain the next one while DREQ stays high.
+ */
+static void VS1053_BurstDone(bool ok, void *arg) {
+  (void)arg;
+  uint32_t start = Profile_Now();
+
+  if (ok) {
+    tail += burst.len;
+    streamStats.bytes += burst.len;
+    streamStats.bursts++;
+  }
+  sending = false;
+
+  VS1053_Feed();
+  VS1053_AddBusy(start);
+}
+
+/**
+ * @brief DREQ rising edge, the decoder has room for at least one burst.
+ */
+static void VS1053_OnDREQ(uint8_t line, EXTIEdge edge) {
+  (void)line;
+  (void)edge;
+  uint32_t start = Profile_Now();
+
+  VS1053_SCIFlush();
+  VS1053_Feed();
+  VS1053_AddBusy(start);
+}
+
+/**
+ * @brief Returns the shadow slot of a register, or VS1053_NO_SHADOW.
+ */
+static uint8_t VS1053_ShadowSlot(uint8_t reg) {
+  for (uint8_t i = 0; i < VS1053_SHADOW_COUNT; i++)
+    if (shadowReg[i] == reg)
+      return i;
+  return VS1053_NO_SHADOW;
+}
+
+/**
+ * @brief SCI transaction finished.
+ */
+static void VS1053_SCIDone(bool ok, void *arg) {
+  (void)ok;
+  (void)arg;
+  sciBusy = false;
+
+  // DREQ is usually low now while the write executes, its rising edge continues the flush
+  VS1053_SCIFlush();
+}
+
+/**
+ * @brief Starts one SCI transaction if DREQ is high and no other one is running.
+ *
+ * Several values for one register go out in a single multiple write, CS stays low between words.
+ * @return false if the transaction could not start.
+ */
+static bool VS1053_SCIStart(uint8_t op, uint8_t reg, const uint16_t *values, uint8_t count) {
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+
+  if (sciBusy || !Pin_DREQ_Read()) {
+    __set_PRIMASK(primask);
+    return false;
+  }
+
+  sciTx[0] = op;
+  sciTx[1] = reg;
+  for (uint8_t i = 0; i < count; i++) {
+    sciTx[2 + 2 * i] = (uint8_t)(values[i] >> 8);
+    sciTx[3 + 2 * i] = (uint8_t)values[i];
+  }
+
+  sci.device   = SPIBUS_DEVICE_SCI;
+  sci.flags    = 0;
+  sci.tx       = sciTx;
+  sci.rx       = (op == VS1053_SCI_OP_READ) ? sciRx : NULL;
+  sci.len      = 2 + 2 * count;
+  sci.callback = VS1053_SCIDone;
+  sci.arg      = NULL;
+
+  sciBusy = true;
+  if (!SPIBus_Submit(&sci)) {
+    sciBusy = false;
+    __set_PRIMASK(primask);
+    return false;
+  }
+
+  if (op == VS1053_SCI_OP_READ)
+    sciStats.bus_reads++;
+  else
+    sciStats.bus_writes++;
+
+  __set_PRIMASK(primask);
+  return true;
+}
+
+/**
+ * @brief Writes the next dirty shadow register if possible.
+ */
+static void VS1053_SCIFlush(void) {
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+
+  for (uint8_t i = 0; i < VS1053_SHADOW_COUNT && shadowDirty; i++) {
+    if (!(shadowDirty & (1 << i)))
+      continue;
+
+    // The latest value goes out, everything written before it is merged
+    if (VS1053_SCIStart(VS1053_SCI_OP_WRITE, shadowReg[i], &shadow[i], 1))
+      shadowDirty &= ~(1 << i);
+    break;
+  }
+
+  __set_PRIMASK(primask);
+}
+
+/**
+ * @brief Runs one blocking SCI transaction, after all pending shadow writes.
+ */
+static bool VS1053_SCITransfer(uint8_t op, uint8_t reg, const uint16_t *values, uint8_t count) {
+  uint32_t deadline = Tick_Deadline(VS1053_SCI_TIMEOUT_MS);
+
+  // Keep the register write order, the shadow goes first
+  while (shadowDirty || !VS1053_SCIStart(op, reg, values, count)) {
+    if (Tick_Expired(deadline))
+      return false;
+    VS1053_SCIFlush();
+  }
+
+  while (sciBusy)
+    if (Tick_Expired(deadline))
+      return false;
+
+  return true;
+}
+
+/**
+ * @brief Waits for DREQ high, bounded by VS1053_SCI_TIMEOUT_MS.
+ */
+static bool VS1053_WaitDREQ(void) {
+  uint32_t deadline = Tick_Deadline(VS1053_SCI_TIMEOUT_MS);
+
+  while (!Pin_DREQ_Read())
+    if (Tick_Expired(deadline))
+      return false;
+
+  return true;
+}
+
+/**
+ * @brief Sets the SCI and SDI bus limits for a given CLKI.
+ */
+static void VS1053_SetBusSpeed(uint32_t clki) {
+  // SCI reads are the slower of the two at CLKI/7, SDI accepts CLKI/4
+  SPIBus_SetSpeed(SPIBUS_DEVICE_SCI, clki / 7);
+  SPIBus_SetSpeed(SPIBUS_DEVICE_SDI, clki / 4);
+}
+
+bool VS1053_Init(void) {
+  uint32_t start = Profile_Now();
+  bootInfo       = (VS1053BootInfo){0};
+
+  // Stage 1: the decoder runs from XTALI, stay at the slow limits
+  VS1053_SetBusSpeed(VS1053_XTALI);
+  bootInfo.sci_hz_before = SPIBus_GetClock(SPIBUS_DEVICE_SCI);
+  bootInfo.sdi_hz_before = SPIBus_GetClock(SPIBUS_DEVICE_SDI);
+
+  if (!VS1053_WaitDREQ())
+    return false;
+
+  // Software reset, XRESET is not wired on this board
+  VS1053_SCIInvalidate();
+  if (!VS1053_SCIWrite(VS1053_SCI_MODE, VS1053_SM_SDINEW | VS1053_SM_RESET) || !VS1053_SCISync())
+    return false;
+
+  // DREQ drops a few cycles after the write, give it time before waiting for it to rise again
+  Tick_Delay(1);
+  VS1053_SCIInvalidate();
+  if (!VS1053_WaitDREQ())
+    return false;
+
+  // Stage 2: raise CLKI, DREQ comes back once the new clock is stable
+  if (!VS1053_SCIWrite(VS1053_SCI_CLOCKF, VS1053_CLOCKF_4_5X) || !VS1053_SCISync())
+    return false;
+
+  Tick_Delay(1);
+  if (!VS1053_WaitDREQ())
+    return false;
+
+  // Stage 3: faster bus, prescalers are derived from the current PCLK by the arbiter
+  VS1053_SetBusSpeed(VS1053_CLKI);
+  bootInfo.sci_hz_after = SPIBus_GetClock(SPIBUS_DEVICE_SCI);
+  bootInfo.sdi_hz_after = SPIBus_GetClock(SPIBUS_DEVICE_SDI);
+
+  // The shadow is empty, so this reads the bus and proves the decoder answers at the new speed
+  uint16_t mode;
+  if (!VS1053_SCIRead(VS1053_SCI_MODE, &mode) || !(mode & VS1053_SM_SDINEW))
+    return false;
+
+  bootInfo.boot_us = Profile_Elapsed(start);
+  return true;
+}
+
+const VS1053BootInfo *VS1053_GetBootInfo(void) {
+  return &bootInfo;
+}
+
+void VS1053_StreamInit(void) {
+  head     = 0;
+  tail     = 0;
+  sending  = false;
+  flushing = false;
+  VS1053_StreamResetStats();
+
+  EXTI_Attach(Pin_DREQ_Port(), PIN_DREQ_NUM, EXTI_EDGE_RISING, VS1053_OnDREQ, VS1053_DREQ_PRIORITY);
+}
+
+uint16_t VS1053_StreamWrite(const uint8_t *data, uint16_t len) {
+  uint32_t start = Profile_Now();
+
+  uint16_t space = VS1053_STREAM_SIZE - (uint16_t)(head - tail);
+  if (len > space)
+    len = space;
+
+  // At most two copies, before and after the wrap
+  uint16_t offset = head & VS1053_STREAM_MASK;
+  uint16_t first  = VS1053_STREAM_SIZE - offset;
+  if (first > len)
+    first = len;
+
+  memcpy(&stream[offset], data, first);
+  memcpy(stream, data + first, len - first);
+  head += len;
+
+  if (len)
+    flushing = false;
+
+  // DREQ may have risen while the buffer was empty, its edge is gone
+  VS1053_Feed();
+
+  VS1053_AddBusy(start);
+  return len;
+}
+
+uint16_t VS1053_StreamFree(void) {
+  return VS1053_STREAM_SIZE - (uint16_t)(head - tail);
+}
+
+uint8_t VS1053_StreamFill(void) {
+  return (uint8_t)(((uint32_t)(uint16_t)(head - tail) * 100) / VS1053_STREAM_SIZE);
+}
+
+void VS1053_StreamFlush(void) {
+  flushing = true;
+  VS1053_Feed();
+}
+
+const VS1053StreamStats *VS1053_StreamGetStats(void) {
+  return &streamStats;
+}
+
+uint16_t VS1053_StreamGetLoad(void) {
+  uint32_t window = Profile_Elapsed(streamStats.since_us);
+  if (!window)
+    return 0;
+
+  return (uint16_t)(((uint64_t)streamStats.busy_us * 1000) / window);
+}
+
+void VS1053_StreamResetStats(void) {
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+
+  streamStats          = (VS1053StreamStats){0};
+  streamStats.since_us = Profile_Now();
+
+  __set_PRIMASK(primask);
+}
+
+bool VS1053_SCIRead(uint8_t reg, uint16_t *value) {
+  if (reg > VS1053_SCI_AICTRL3 || !value)
+    return false;
+
+  uint8_t slot = VS1053_ShadowSlot(reg);
+  if (slot != VS1053_NO_SHADOW && (shadowValid & (1 << slot))) {
+    *value = shadow[slot];
+    sciStats.saved_reads++;
+    return true;
+  }
+
+  uint16_t dummy = 0;
+  if (!VS1053_SCITransfer(VS1053_SCI_OP_READ, reg, &dummy, 1))
+    return false;
+
+  *value = (uint16_t)((sciRx[2] << 8) | sciRx[3]);
+
+  // MODE stays on the bus until a pending SM_CANCEL has cleared, AUDATA always
+  if (slot != VS1053_NO_SHADOW && !((1 << slot) & VS1053_SHADOW_LIVE) && !(*value & VS1053_SM_SELF_CLEAR)) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (!(shadowDirty & (1 << slot))) {
+      shadow[slot] = *value;
+      shadowValid |= 1 << slot;
+    }
+
+    __set_PRIMASK(primask);
+  }
+  return true;
+}
+
+bool VS1053_SCIWrite(uint8_t reg, uint16_t value) {
+  if (reg > VS1053_SCI_AICTRL3)
+    return false;
+
+  uint8_t slot = VS1053_ShadowSlot(reg);
+  if (slot == VS1053_NO_SHADOW)
+    return VS1053_SCITransfer(VS1053_SCI_OP_WRITE, reg, &value, 1);
+
+  // SM_RESET and SM_CANCEL are commands, never merged away and never kept in the shadow
+  if (slot == VS1053_SLOT_MODE && (value & VS1053_SM_SELF_CLEAR)) {
+    if (!VS1053_SCITransfer(VS1053_SCI_OP_WRITE, reg, &value, 1))
+      return false;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    // A reset loses every register, a cancel is polled on the bus until the decoder clears it
+    shadow[slot] = value & ~VS1053_SM_SELF_CLEAR;
+    shadowValid  = (value & VS1053_SM_RESET) ? 0 : (shadowValid & ~(1 << slot));
+
+    __set_PRIMASK(primask);
+    return true;
+  }
+
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+
+  uint8_t bit = 1 << slot;
+
+  if (shadowDirty & bit) {
+    // Replaces a value that never reached the bus
+    shadow[slot] = value;
+    sciStats.saved_writes++;
+  } else if ((shadowValid & bit) && shadow[slot] == value) {
+    // Unchanged
+    sciStats.saved_writes++;
+  } else {
+    shadow[slot] = value;
+    shadowDirty |= bit;
+  }
+  shadowValid |= bit & ~VS1053_SHADOW_LIVE;
+
+  __set_PRIMASK(primask);
+
+  VS1053_SCIFlush();
+  return true;
+}
+
+bool VS1053_SCIWriteMulti(uint8_t reg, const uint16_t *values, uint8_t count) {
+  if (reg > VS1053_SCI_AICTRL3 || !values || !count || count > VS1053_SCI_BATCH)
+    return false;
+
+  // Shadowed registers keep going through the shadow, only the last value matters
+  if (VS1053_ShadowSlot(reg) != VS1053_NO_SHADOW) {
+    sciStats.saved_writes += count - 1;
+    return VS1053_SCIWrite(reg, values[count - 1]);
+  }
+
+  return VS1053_SCITransfer(VS1053_SCI_OP_WRITE, reg, values, count);
+}
+
+bool VS1053_SCISync(void) {
+  uint32_t deadline = Tick_Deadline(VS1053_SCI_TIMEOUT_MS);
+
+  while (shadowDirty || sciBusy) {
+    if (Tick_Expired(deadline))
+      return false;
+    VS1053_SCIFlush();
+  }
+
+  return true;
+}
+
+void VS1053_SCIInvalidate(void) {
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+
+  shadowValid = 0;
+  shadowDirty = 0;
+
+  __set_PRIMASK(primask);
+}
+
+const VS1053SCIStats *VS1053_SCIGetStats(void) {
+  return &sciStats;
+}
@@ -0,0 +1,196 @@
+/**
+ * @file    vs1053.h
+ * @brief   VS1053B audio decoder driver
+ * @author  Joshua
+ * @date    2025-11-02
+ *
+ * The decoder sits on the shared SPI1 bus (see spibus.h): SDI data under XDCS (PA15), SCI
+ * commands under MP3_CS (PB0), DREQ on PB1.
+ *
+ * SDI streaming: the main loop copies file data into a ring buffer with VS1053_StreamWrite. The
+ * DREQ rising edge starts 32-byte DMA bursts, which chain from the DMA interrupt while DREQ stays
+ * high, so the main loop never waits on the decoder.
+ *
+ * SCI registers: MODE, BASS, CLOCKF, AUDATA and VOL are shadowed in RAM. Reads of a known value
+ * never touch the bus, writes only update the shadow and mark it dirty. Dirty registers are
+ * flushed one SCI write at a time whenever DREQ allows it, so a burst of volume changes from the
+ * encoder ends up as one or two bus writes carrying the latest value. AUDATA, which the decoder
+ * rewrites from each stream header, and MODE while an SM_CANCEL is pending are always read from
+ * the bus; SM_RESET and SM_CANCEL writes go out at once and never enter the shadow.
+ *
+ * Boot: VS1053_Init resets the decoder at the slow XTALI based SPI clocks, raises CLKI with
+ * SCI_CLOCKF and only then switches the SCI and SDI bus profiles to the faster limits.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define VS1053_BURST 32            // Bytes the VS1053 always accepts while DREQ is high
+#define VS1053_STREAM_SIZE 1024    // SDI ring buffer, power of two and a multiple of VS1053_BURST
+
+#define VS1053_SCI_TIMEOUT_MS 100    // Max. time a blocking SCI access waits for DREQ and the bus
+#define VS1053_SCI_BATCH 16          // Max. words of one SCI multiple write
+
+#define VS1053_XTALI 12288000UL               // Crystal, CLKI after reset
+#define VS1053_CLKI (VS1053_XTALI * 9 / 2)    // CLKI with SC_MULT = 4.5x
+#define VS1053_CLOCKF_4_5X 0xC000             // SCI_CLOCKF: SC_MULT = 6 (4.5x), no SC_ADD
+#define VS1053_SM_RESET 0x0004                // SCI_MODE: software reset
+#define VS1053_SM_CANCEL 0x0008               // SCI_MODE: cancel decoding the current file
+#define VS1053_SM_SDINEW 0x0800               // SCI_MODE: VS1002 native SPI modes
+
+// SCI registers
+#define VS1053_SCI_MODE 0x00
+#define VS1053_SCI_STATUS 0x01
+#define VS1053_SCI_BASS 0x02
+#define VS1053_SCI_CLOCKF 0x03
+#define VS1053_SCI_DECODE_TIME 0x04
+#define VS1053_SCI_AUDATA 0x05
+#define VS1053_SCI_WRAM 0x06
+#define VS1053_SCI_WRAMADDR 0x07
+#define VS1053_SCI_HDAT0 0x08
+#define VS1053_SCI_HDAT1 0x09
+#define VS1053_SCI_AIADDR 0x0A
+#define VS1053_SCI_VOL 0x0B
+#define VS1053_SCI_AICTRL0 0x0C
+#define VS1053_SCI_AICTRL1 0x0D
+#define VS1053_SCI_AICTRL2 0x0E
+#define VS1053_SCI_AICTRL3 0x0F
+
+/**
+ * @brief Statistics of the SDI stream
+ */
+typedef struct {
+  uint32_t bytes;          // Bytes sent to the decoder
+  uint32_t bursts;         // SDI transfers
+  uint32_t starvations;    // DREQ high with an empty buffer, the decoder may underrun
+  uint32_t busy_us;        // CPU time spent feeding (ISRs and VS1053_StreamWrite)
+  uint32_t since_us;       // Profile_Now timestamp of the last VS1053_StreamResetStats
+} VS1053StreamStats;
+
+/**
+ * @brief Statistics of the SCI port
+ */
+typedef struct {
+  uint32_t bus_reads;       // SCI read transactions
+  uint32_t bus_writes;      // SCI write transactions
+  uint32_t saved_reads;     // Reads answered from the shadow
+  uint32_t saved_writes;    // Writes dropped as unchanged or merged into a pending write
+} VS1053SCIStats;
+
+/**
+ * @brief Timing of the last VS1053_Init
+ */
+typedef struct {
+  uint32_t boot_us;          // VS1053_Init start to decoder ready
+  uint32_t sdi_hz_before;    // SDI clock at XTALI
+  uint32_t sdi_hz_after;     // SDI clock at the raised CLKI
+  uint32_t sci_hz_before;    // SCI clock at XTALI
+  uint32_t sci_hz_after;     // SCI clock at the raised CLKI
+} VS1053BootInfo;
+
+/**
+ * @brief Boots the decoder: software reset, SCI_CLOCKF to 4.5x, then full-speed SCI and SDI.
+ * Note:
+ *  Requires SPIBus_Init, Profile_Init, Tick_Init and VS1053_StreamInit.
+ *  The SPI clocks follow Clock_GetPCLK, the reached speeds are in VS1053_GetBootInfo.
+ * @return false if the decoder did not answer or DREQ never came back.
+ */
+bool VS1053_Init(void);
+
+/**
+ * @brief Returns the timing of the last VS1053_Init.
+ */
+const VS1053BootInfo *VS1053_GetBootInfo(void);
+
+/**
+ * @brief Empties the ring buffer and attaches the DREQ rising edge interrupt.
+ * Note:
+ *  Requires SPIBus_Init and Profile_Init.
+ */
+void VS1053_StreamInit(void);
+
+/**
+ * @brief Copies data into the ring buffer and starts a burst if the decoder is waiting.
+ * @return Bytes accepted, less than @p len when the buffer is full.
+ */
+uint16_t VS1053_StreamWrite(const uint8_t *data, uint16_t len);
+
+/**
+ * @brief Returns the free space of the ring buffer in bytes.
+ */
+uint16_t VS1053_StreamFree(void);
+
+/**
+ * @brief Returns the ring buffer fill level in percent, e.g. for GovernorInput.buffer_fill.
+ */
+uint8_t VS1053_StreamFill(void);
+
+/**
+ * @brief Allows a final burst shorter than VS1053_BURST, call after the last VS1053_StreamWrite of a file.
+ * Note:
+ *  Cleared again by the next VS1053_StreamWrite.
+ */
+void VS1053_StreamFlush(void);
+
+/**
+ * @brief Returns the stream statistics.
+ */
+const VS1053StreamStats *VS1053_StreamGetStats(void);
+
+/**
+ * @brief Returns the CPU share spent feeding the decoder since the last reset.
+ * @return Load in 0.1 % steps (50 = 5 %).
+ */
+uint16_t VS1053_StreamGetLoad(void);
+
+/**
+ * @brief Clears the statistics and starts a new load measurement window.
+ */
+void VS1053_StreamResetStats(void);
+
+/**
+ * @brief Reads an SCI register, from the shadow when its value is known.
+ * Note:
+ *  Blocks until DREQ and the bus allow the access, at most VS1053_SCI_TIMEOUT_MS.
+ * @return false on a timeout or an invalid register.
+ */
+bool VS1053_SCIRead(uint8_t reg, uint16_t *value);
+
+/**
+ * @brief Writes an SCI register.
+ * Note:
+ *  Shadowed registers return at once and are flushed in the background (driven by the DREQ
+ *  interrupt of VS1053_StreamInit), writes to the same register coalesce. A MODE write with
+ *  SM_RESET or SM_CANCEL blocks and is never coalesced. Other registers
+ *  (WRAM, WRAMADDR, AIADDR, AICTRLx...) are written in order, after every pending shadowed
+ *  write, and block like VS1053_SCIRead.
+ * @return false on a timeout or an invalid register.
+ */
+bool VS1053_SCIWrite(uint8_t reg, uint16_t value);
+
+/**
+ * @brief Writes up to VS1053_SCI_BATCH words to one register in a single SCI multiple write.
+ * Note:
+ *  Meant for WRAM uploads, blocks like VS1053_SCIRead. For a shadowed register only the last
+ *  value is written.
+ * @return false on a timeout, an invalid register or count.
+ */
+bool VS1053_SCIWriteMulti(uint8_t reg, const uint16_t *values, uint8_t count);
+
+/**
+ * @brief Waits until every pending shadowed write has reached the VS1053.
+ * @return false on a timeout.
+ */
+bool VS1053_SCISync(void);
+
+/**
+ * @brief Forgets the shadow, e.g. after a hardware reset the driver did not issue.
+ */
+void VS1053_SCIInvalidate(void);
+
+/**
+ * @brief Returns the SCI statistics.
+ */
+const VS1053SCIStats *VS1053_SCIGetStats(void);
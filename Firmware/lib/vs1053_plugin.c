@@ -0,0 +1,117 @@
+/**
+ * @file    vs1053_plugin.c
+ * @brief   Loader for VLSI compressed VS1053B plugins and patches
+ * @author  Joshua
+ * @date    2025-11-02
+ */
+
+#include "vs1053_plugin.h"
+#include "profile.h"
+#include "vs1053.h"
+
+/**
+ * @brief Read position in a flash image
+ */
+typedef struct {
+  const uint16_t *next;
+  uint32_t left;
+} VS1053PluginFlash;
+
+static VS1053PluginStats pluginStats;
+
+/**
+ * @brief VS1053PluginReader for images in flash.
+ */
+static uint16_t VS1053_ReadFlash(void *ctx, uint16_t *words, uint16_t count) {
+  VS1053PluginFlash *flash = ctx;
+
+  if (count > flash->left)
+    count = (uint16_t)flash->left;
+
+  for (uint16_t i = 0; i < count; i++)
+    words[i] = flash->next[i];
+
+  flash->next += count;
+  flash->left -= count;
+  return count;
+}
+
+/**
+ * @brief Writes one batch and updates the statistics.
+ */
+static bool VS1053_WriteBatch(uint8_t reg, const uint16_t *values, uint8_t count) {
+  if (!VS1053_SCIWriteMulti(reg, values, count))
+    return false;
+
+  pluginStats.words += count;
+  pluginStats.transactions++;
+  return true;
+}
+
+bool VS1053_LoadPlugin(VS1053PluginReader reader, void *ctx) {
+  uint32_t start = Profile_Now();
+  uint16_t batch[VS1053_SCI_BATCH];
+  uint16_t header[2];
+
+  pluginStats = (VS1053PluginStats){0};
+
+  while (1) {
+    // A clean end of image can only fall between records
+    uint16_t got = reader(ctx, header, 2);
+    pluginStats.image_bytes += got * 2;
+    if (!got)
+      break;
+    if (got < 2)
+      return false;
+
+    uint8_t reg    = (uint8_t)header[0];
+    uint16_t count = header[1];
+
+    if (count & VS1053_PLUGIN_RLE) {
+      count &= ~VS1053_PLUGIN_RLE;
+
+      if (reader(ctx, batch, 1) != 1)
+        return false;
+      pluginStats.image_bytes += 2;
+
+      // One word in the image, expanded into full batches
+      for (uint8_t i = 1; i < VS1053_SCI_BATCH; i++)
+        batch[i] = batch[0];
+
+      while (count) {
+        uint8_t chunk = (count > VS1053_SCI_BATCH) ? VS1053_SCI_BATCH : (uint8_t)count;
+        if (!VS1053_WriteBatch(reg, batch, chunk))
+          return false;
+        count -= chunk;
+      }
+    } else {
+      while (count) {
+        uint8_t chunk = (count > VS1053_SCI_BATCH) ? VS1053_SCI_BATCH : (uint8_t)count;
+        if (reader(ctx, batch, chunk) != chunk)
+          return false;
+        pluginStats.image_bytes += chunk * 2;
+
+        if (!VS1053_WriteBatch(reg, batch, chunk))
+          return false;
+        count -= chunk;
+      }
+    }
+  }
+
+  // Shadowed registers (MODE, VOL...) may still be on their way, the plugin is loaded only once
+  // the last word has reached the decoder
+  if (!VS1053_SCISync())
+    return false;
+
+  pluginStats.load_us = Profile_Elapsed(start);
+  return true;
+}
+
+bool VS1053_LoadPluginImage(const uint16_t *image, uint32_t words) {
+  VS1053PluginFlash flash = {.next = image, .left = words};
+  return VS1053_LoadPlugin(VS1053_ReadFlash, &flash);
+}
+
+const VS1053PluginStats *VS1053_GetPluginStats(void) {
+  return &pluginStats;
+}
@@ -0,0 +1,61 @@
+/**
+ * @file    vs1053_plugin.h
+ * @brief   Loader for VLSI compressed VS1053B plugins and patches
+ * @author  Joshua
+ * @date    2025-11-02
+ *
+ * VLSI ships plugins (FLAC decoder, spectrum analyzer, patches) as a list of 16-bit words:
+ *   addr, n, value * n          n words written one after another to SCI register addr
+ *   addr, 0x8000 | n, value     value written n times (run-length repeat)
+ *
+ * The loader streams such an image through the SCI driver, expands repeats on the fly and sends
+ * the words of each record as SCI multiple writes of up to VS1053_SCI_BATCH words.
+ *
+ * Images in flash go to their own section at the end of FLASH (see STM32G0xx_Flash.icf):
+ *   const uint16_t flac_plugin[] VS1053_PLUGIN_SECTION = { ... };
+ *   VS1053_LoadPluginImage(flac_plugin, sizeof(flac_plugin) / sizeof(flac_plugin[0]));
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define VS1053_PLUGIN_SECTION __attribute__((section(".vs1053_plugins")))
+#define VS1053_PLUGIN_RLE 0x8000    // Record length flag for a run-length repeat
+
+/**
+ * @brief Reads the next words of an image, e.g. from a file on the SD card.
+ * @return Words read, less than @p count only at the end of the image.
+ */
+typedef uint16_t (*VS1053PluginReader)(void *ctx, uint16_t *words, uint16_t count);
+
+/**
+ * @brief Statistics of the last load
+ */
+typedef struct {
+  uint32_t image_bytes;     // Compressed image size, the flash footprint for flash images
+  uint32_t words;           // Words written to the VS1053 after expansion
+  uint32_t transactions;    // SCI transactions used, one per word without batching
+  uint32_t load_us;         // Load time, until the last SCI write has completed
+} VS1053PluginStats;
+
+/**
+ * @brief Loads a compressed image from any source.
+ * Note:
+ *  Requires VS1053_Init. Blocks until the whole image has reached the decoder, including
+ *  records for shadowed registers.
+ * @return false on a truncated image or an SCI timeout.
+ */
+bool VS1053_LoadPlugin(VS1053PluginReader reader, void *ctx);
+
+/**
+ * @brief Loads a compressed image stored in flash.
+ * @param words Image length in 16-bit words.
+ */
+bool VS1053_LoadPluginImage(const uint16_t *image, uint32_t words);
+
+/**
+ * @brief Returns the statistics of the last load.
+ */
+const VS1053PluginStats *VS1053_GetPluginStats(void);
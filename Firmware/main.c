@@ -11,30 +11,55 @@
 
 #include "clock.h"
 #include "gpio.h"
+#include "pins.h"
+#include "tick.h"
 
-static void delay_ms(uint32_t ms) {
-  volatile uint32_t i;
-  for (i = 0; i < (ms * 1000); i++)
-    __NOP();
-}
+// Board pinout from the README, plus USART2 on the ST-LINK VCP
+static const GPIOPinConfig boardPins[] = {
+    // SPI1 (AF0), shared by the VS1053B and the SD card
+    {GPIOA, PIN_SPI1_SCK_NUM, GPIO_MODE_AF, GPIO_OTYPE_PP, GPIO_SPEED_VERY_HIGH, GPIO_NOPULL, 0, 0},
+    {GPIOA, PIN_SPI1_MISO_NUM, GPIO_MODE_AF, GPIO_OTYPE_PP, GPIO_SPEED_VERY_HIGH, GPIO_PULLUP, 0, 0},
+    {GPIOA, PIN_SPI1_MOSI_NUM, GPIO_MODE_AF, GPIO_OTYPE_PP, GPIO_SPEED_VERY_HIGH, GPIO_NOPULL, 0, 0},
 
-ClockPLLConfig pll_cfg = {.pll_m = 1, .pll_n = 8, .pll_p = 2, .pll_q = 4, .pll_r = 2};
+    // Chip selects, idle high
+    {GPIOA, PIN_XDCS_NUM, GPIO_MODE_OUTPUT, GPIO_OTYPE_PP, GPIO_SPEED_HIGH, GPIO_NOPULL, 0, 1},
+    {GPIOB, PIN_MP3_CS_NUM, GPIO_MODE_OUTPUT, GPIO_OTYPE_PP, GPIO_SPEED_HIGH, GPIO_NOPULL, 0, 1},
+    {GPIOB, PIN_SD_CS_NUM, GPIO_MODE_OUTPUT, GPIO_OTYPE_PP, GPIO_SPEED_HIGH, GPIO_NOPULL, 0, 1},
+    {GPIOB, PIN_DREQ_NUM, GPIO_MODE_INPUT, GPIO_OTYPE_PP, GPIO_SPEED_LOW, GPIO_NOPULL, 0, 0},
+
+    // Rotary encoder and buttons, active low
+    {GPIOA, PIN_ENC_R_NUM, GPIO_MODE_INPUT, GPIO_OTYPE_PP, GPIO_SPEED_LOW, GPIO_PULLUP, 0, 0},
+    {GPIOA, PIN_ENC_L_NUM, GPIO_MODE_INPUT, GPIO_OTYPE_PP, GPIO_SPEED_LOW, GPIO_PULLUP, 0, 0},
+    {GPIOB, PIN_BTN_PLAY_NUM, GPIO_MODE_INPUT, GPIO_OTYPE_PP, GPIO_SPEED_LOW, GPIO_PULLUP, 0, 0},
+    {GPIOB, PIN_BTN_NEXT_NUM, GPIO_MODE_INPUT, GPIO_OTYPE_PP, GPIO_SPEED_LOW, GPIO_PULLUP, 0, 0},
+    {GPIOB, PIN_BTN_BACK_NUM, GPIO_MODE_INPUT, GPIO_OTYPE_PP, GPIO_SPEED_LOW, GPIO_PULLUP, 0, 0},
+
+    // I2C1 (AF6) for the SSD1306
+    {GPIOB, PIN_OLED_SCL_NUM, GPIO_MODE_AF, GPIO_OTYPE_OD, GPIO_SPEED_MEDIUM, GPIO_PULLUP, 6, 0},
+    {GPIOB, PIN_OLED_SDA_NUM, GPIO_MODE_AF, GPIO_OTYPE_OD, GPIO_SPEED_MEDIUM, GPIO_PULLUP, 6, 0},
+
+    // USART2 (AF1) TX/RX on PA2/PA3
+    {GPIOA, 2, GPIO_MODE_AF, GPIO_OTYPE_PP, GPIO_SPEED_MEDIUM, GPIO_NOPULL, 1, 0},
+    {GPIOA, 3, GPIO_MODE_AF, GPIO_OTYPE_PP, GPIO_SPEED_MEDIUM, GPIO_PULLUP, 1, 0},
+
+    // LED_PAUSED on, LED_PLAYING off
+    {GPIOB, PIN_LED_PAUSED_NUM, GPIO_MODE_OUTPUT, GPIO_OTYPE_PP, GPIO_SPEED_MEDIUM, GPIO_NOPULL, 0, 1},
+    {GPIOB, PIN_LED_PLAYING_NUM, GPIO_MODE_OUTPUT, GPIO_OTYPE_PP, GPIO_SPEED_MEDIUM, GPIO_NOPULL, 0, 0},
+};
 
 /**
  * @brief  Main program entry point
  */
 int main(void) {
   Clock_InitBaseClock(CLOCK_BASE_SOURCE_LSI);
+  Clock_MeasureLSI();
+  Tick_Init();
   Clock_EnableMCO(MCO_SRC_LSI, CLOCK_DIV_BY_1);
-  GPIO_EnablePin(GPIOB, 2, GPIO_OTYPE_PP, GPIO_MODE_OUTPUT, GPIO_SPEED_MEDIUM, GPIO_NOPULL);
-  GPIO_Write(GPIOB, 2, 1);
-
-  GPIO_EnablePin(GPIOB, 8, GPIO_OTYPE_PP, GPIO_MODE_OUTPUT, GPIO_SPEED_MEDIUM, GPIO_NOPULL);
-  GPIO_Write(GPIOB, 8, 0);
+  GPIO_ConfigurePort(boardPins, sizeof(boardPins) / sizeof(boardPins[0]));
 
   while (1) {
-    delay_ms(1);
-    GPIO_Toggle(GPIOB, 2);
-    GPIO_Toggle(GPIOB, 8);
+    Tick_Delay(1);
+    Pin_LED_PAUSED_Toggle();
+    Pin_LED_PLAYING_Toggle();
   }
 }
\ No newline at end of file
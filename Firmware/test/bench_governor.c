@@ -0,0 +1,110 @@
+/**
+ * @file    bench_governor.c
+ * @brief   Host-simulated playback benchmark of the frequency governor
+ * @author  Joshua
+ * @date    2025-11-02
+ *
+ * One Governor_Update per simulated millisecond. The decoder drains the stream buffer at the
+ * stream bitrate, the SD refill runs at the current HCLK with a fixed cost per byte, and the card
+ * stalls now and then (busy after a write, FAT lookup at a cluster boundary). The real clock.c
+ * switches levels against the simulated RCC, so the average clock is the HCLK actually reached.
+ */
+
+#include "clock.h"
+#include "governor.h"
+#include "spibus.h"
+#include "stm32g031xx.h"
+#include "test.h"
+
+#define BENCH_BUFFER 4096UL            // Stream buffer between the SD card and the decoder
+#define BENCH_CYCLES_PER_BYTE 64UL     // SD read over SPI plus FAT bookkeeping, per byte
+#define BENCH_STALL_PERIOD_MS 750UL    // Card busy every ...
+#define BENCH_STALL_MS 30UL            // ... for this long
+#define BENCH_BURST_MS 5UL             // FAT lookup right after a stall, needs full speed
+#define BENCH_PAUSE_AT_MS 6000UL       // User pauses ...
+#define BENCH_PAUSE_MS 1000UL          // ... for a second
+#define BENCH_DURATION_MS 12000UL
+
+// The SD refill is modelled as a rate, no transfer is ever on the wire at an update
+bool SPIBus_IsActive(void) {
+  return false;
+}
+
+/**
+ * @brief Result of one simulated stream
+ */
+typedef struct {
+  uint32_t average_hz;
+  uint32_t underruns;
+  uint32_t transitions;
+} BenchResult;
+
+/**
+ * @brief Plays one stream of the given bitrate through the governor.
+ */
+static BenchResult Bench_Play(uint16_t bitrate_kbps) {
+  Host_Reset();
+  CHECK(Clock_ApplyProfile(CLOCK_PROFILE_PLAYBACK_ECONOMY));
+  Governor_Init();
+
+  // File opened, the first clusters are already buffered
+  uint32_t fill   = BENCH_BUFFER;
+  uint32_t bits   = 0;
+  uint32_t cycles = 0;    // Refill cycles not yet worth a whole byte
+
+  for (uint32_t ms = 0; ms < BENCH_DURATION_MS; ms++) {
+    bool paused  = ms >= BENCH_PAUSE_AT_MS && ms < BENCH_PAUSE_AT_MS + BENCH_PAUSE_MS;
+    uint32_t pos = ms % BENCH_STALL_PERIOD_MS;
+    bool stalled = pos >= BENCH_STALL_PERIOD_MS - BENCH_STALL_MS;
+    bool burst   = pos < BENCH_BURST_MS && ms >= BENCH_STALL_PERIOD_MS;
+
+    // Decoder side, bitrate in kbps is bits per millisecond
+    if (!paused) {
+      bits += bitrate_kbps;
+      uint32_t bytes = bits / 8;
+      bits %= 8;
+      fill = (fill > bytes) ? fill - bytes : 0;
+    }
+
+    // SD side, as fast as the core clock allows
+    if (!stalled) {
+      cycles += Clock_GetHCLK() / 1000;
+      uint32_t bytes = cycles / BENCH_CYCLES_PER_BYTE;
+      cycles %= BENCH_CYCLES_PER_BYTE;
+      fill = (fill + bytes < BENCH_BUFFER) ? fill + bytes : BENCH_BUFFER;
+    }
+
+    GovernorInput input = {
+        .playing      = !paused,
+        .sd_burst     = burst,
+        .buffer_fill  = (uint8_t)(fill * 100 / BENCH_BUFFER),
+        .bitrate_kbps = bitrate_kbps,
+    };
+    Governor_Update(&input);
+  }
+
+  const GovernorStats *stats = Governor_GetStats();
+  return (BenchResult){Governor_GetAverageClock(), stats->underruns, stats->transitions};
+}
+
+static void Bench_Report(uint16_t bitrate_kbps, const BenchResult *result) {
+  printf("  %3u kbps: average HCLK %6.3f MHz, %u underruns, %u transitions\n", (unsigned)bitrate_kbps,
+         result->average_hz / 1e6, (unsigned)result->underruns, (unsigned)result->transitions);
+}
+
+int main(void) {
+  BenchResult low  = Bench_Play(128);
+  BenchResult high = Bench_Play(320);
+
+  Bench_Report(128, &low);
+  Bench_Report(320, &high);
+
+  CHECK_EQ(low.underruns, 0);
+  CHECK_EQ(high.underruns, 0);
+
+  // Well below the fixed 64 MHz a governor-less player would run at
+  CHECK(low.average_hz < high.average_hz);
+  CHECK(high.average_hz < 32000000UL);
+
+  return TEST_RESULT("bench_governor");
+}
@@ -0,0 +1,164 @@
+/**
+ * @file    bench_spi.c
+ * @brief   Host-simulated byte gap of the programmed I/O path and sustained DMA throughput
+ * @author  Joshua
+ * @date    2025-11-02
+ *
+ * spi.c runs against the simulated SPI1 of host/spi1.c. The plain loop is what SPI_TransferPolled
+ * used to be: write one byte, poll RXNE, read one byte. The gap is the SCK idle time between two
+ * bytes, in CPU cycles, averaged over the transfer.
+ *
+ * The DMA table counts the peripheral accesses of SPI_TransmitReceive and of the completion
+ * interrupt, prices them like the PIO path and adds the wire time, assuming the DMA keeps the TX
+ * FIFO fed (a channel needs a few cycles per byte, a byte takes 16 or more). Sustained throughput is
+ * back-to-back bursts of one size at PCLK 64 MHz, without the SPIBus queue and chip select.
+ *
+ * These are computed figures, not measurements on the board. BENCH_ACCESS_CYCLES stands in for the
+ * peripheral access plus the instructions around it, BENCH_IRQ_CYCLES for exception entry and exit
+ * on the Cortex-M0+ (16 + 16 cycles without wait states); both are estimates.
+ */
+
+#include "spi1.h"
+
+#include <stdio.h>
+
+#define SPI_READ_DR8() ((uint8_t)HostSpi_Read(8))
+#define SPI_READ_DR16() HostSpi_Read(16)
+#define SPI_WRITE_DR8(data) HostSpi_Write(8, (data))
+#define SPI_WRITE_DR16(data) HostSpi_Write(16, (data))
+
+#include "../lib/spi.c"
+
+#include "test.h"
+
+#define BENCH_LEN 15            // Longest transfer below SPI_DMA_MIN_LEN
+#define BENCH_ACCESS_CYCLES 4
+#define BENCH_IRQ_CYCLES 32
+#define BENCH_PCLK_HZ 64000000UL
+
+static uint8_t txBuf[BENCH_LEN];
+static uint8_t rxBuf[BENCH_LEN];
+static bool done;
+
+static void OnDone(bool ok, void *arg) {
+  (void)arg;
+  done = ok;
+}
+
+/**
+ * @brief One byte per round trip, the SCK stops while the CPU reads and refills DR.
+ */
+static bool Plain_Transfer(const uint8_t *tx, uint8_t *rx, uint16_t len) {
+  for (uint16_t i = 0; i < len; i++) {
+    HostSpi_Write(8, tx[i]);
+
+    uint32_t timeout = 0;
+    while (!(SPI1->SR & SPI_SR_RXNE))
+      if (timeout++ > SPI_TIMEOUT)
+        return false;
+
+    rx[i] = (uint8_t)HostSpi_Read(8);
+  }
+  return true;
+}
+
+/**
+ * @brief SPI_TransferIT with the exception overhead charged before every handler run.
+ */
+static bool IT_Transfer(const uint8_t *tx, uint8_t *rx, uint16_t len) {
+  done = false;
+  if (!SPI_TransferIT(tx, rx, len, OnDone, NULL))
+    return false;
+
+  for (uint32_t i = 0; i < 100000 && !done; i++) {
+    HostSpi_Advance(1);
+    if ((hostRegs.spi1.SR & SPI_SR_RXNE) && (hostRegs.spi1.CR2 & SPI_CR2_RXNEIE)) {
+      HostSpi_Advance(BENCH_IRQ_CYCLES);
+      SPI1_IRQHandler();
+    }
+  }
+  return done;
+}
+
+static bool Polled_Transfer(const uint8_t *tx, uint8_t *rx, uint16_t len) {
+  return SPI_TransferPolled(tx, rx, len);
+}
+
+/**
+ * @brief Average SCK idle cycles between two bytes of one transfer at @p baud.
+ */
+static double Bench_Gap(SPIBaud baud, bool (*transfer)(const uint8_t *, uint8_t *, uint16_t)) {
+  Host_Reset();
+  SPI_Init(baud, SPI_MODE_0);
+  HostSpi_Reset(BENCH_ACCESS_CYCLES);
+
+  for (uint8_t i = 0; i < BENCH_LEN; i++)
+    txBuf[i] = (uint8_t)(i * 29);
+
+  CHECK(transfer(txBuf, rxBuf, BENCH_LEN));
+  CHECK_EQ(hostSpi.bytes, BENCH_LEN);
+  CHECK_EQ(hostSpi.overruns, 0);
+  CHECK_EQ(rxBuf[BENCH_LEN - 1], (uint8_t)~txBuf[BENCH_LEN - 1]);
+
+  return (double)hostSpi.gap_cycles / (BENCH_LEN - 1);
+}
+
+/**
+ * @brief CPU cycles of one DMA burst: setup, the completion interrupt, and the wire time of @p len bytes.
+ */
+static uint32_t Bench_DMABurst(SPIBaud baud, uint16_t len, uint32_t *overhead) {
+  static uint8_t buf[512];
+
+  Host_Reset();
+  SPI_Init(baud, SPI_MODE_0);
+  HostSpi_Reset(BENCH_ACCESS_CYCLES);
+
+  uint32_t start = hostSpi.accesses;
+  CHECK(SPI_TransmitReceive(buf, buf, len, OnDone, NULL));
+  uint32_t setup = hostSpi.accesses - start;
+
+  // RX channel finished
+  done              = false;
+  hostRegs.dma1.ISR = DMA_ISR_TCIF2;
+  start             = hostSpi.accesses;
+  DMA1_Channel2_3_IRQHandler();
+  uint32_t irq = hostSpi.accesses - start;
+  CHECK(done);
+
+  *overhead = (setup + irq) * BENCH_ACCESS_CYCLES + BENCH_IRQ_CYCLES;
+  return *overhead + len * (8UL << (baud + 1));
+}
+
+int main(void) {
+  printf("  %u-byte transfer, SCK idle cycles between bytes (%u cycles per access)\n", BENCH_LEN,
+         BENCH_ACCESS_CYCLES);
+  printf("  %-8s %10s %10s %10s %10s\n", "SCK", "byte time", "plain", "polled", "IT");
+
+  for (SPIBaud baud = SPI_BAUD_DIV_2; baud <= SPI_BAUD_DIV_8; baud++) {
+    double plain  = Bench_Gap(baud, Plain_Transfer);
+    double polled = Bench_Gap(baud, Polled_Transfer);
+    double it     = Bench_Gap(baud, IT_Transfer);
+
+    printf("  PCLK/%-3u %10u %10.1f %10.1f %10.1f\n", 2U << baud, 8U << (baud + 1), plain, polled, it);
+
+    // Packing two bytes per access must never leave more idle SCK than one byte per round trip
+    CHECK(polled <= plain);
+  }
+
+  printf("  DMA, sustained kB/s at PCLK %lu MHz (overhead cycles per burst)\n", BENCH_PCLK_HZ / 1000000UL);
+  printf("  %-8s %10s %16s %16s\n", "SCK", "wire", "32-byte SDI", "512-byte sector");
+
+  for (SPIBaud baud = SPI_BAUD_DIV_2; baud <= SPI_BAUD_DIV_256; baud++) {
+    uint32_t overhead_sdi    = 0;
+    uint32_t overhead_sector = 0;
+    uint32_t sdi             = Bench_DMABurst(baud, 32, &overhead_sdi);
+    uint32_t sector          = Bench_DMABurst(baud, 512, &overhead_sector);
+    uint32_t wire            = BENCH_PCLK_HZ / (8UL << (baud + 1));
+
+    printf("  PCLK/%-3u %10lu %10lu (%3lu) %10lu (%3lu)\n", 2U << baud, wire / 1000UL,
+           (unsigned long)(32ULL * BENCH_PCLK_HZ / sdi / 1000U), (unsigned long)overhead_sdi,
+           (unsigned long)(512ULL * BENCH_PCLK_HZ / sector / 1000U), (unsigned long)overhead_sector);
+  }
+
+  return TEST_RESULT("bench_spi");
+}
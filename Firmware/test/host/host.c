@@ -0,0 +1,151 @@
+/**
+ * @file    host.c
+ * @brief   Simulated STM32G031 peripherals for the host tests
+ * @author  Joshua
+ * @date    2025-11-02
+ */
+
+#include <stm32g031xx.h>    // Through the include path, so include_next finds the device header
+
+#include <stdio.h>
+#include <string.h>
+
+// Normally provided by system_stm32g0xx.c
+uint32_t SystemCoreClock         = 16000000UL;
+const uint32_t AHBPrescTable[16] = {0UL, 0UL, 0UL, 0UL, 0UL, 0UL, 0UL, 0UL, 1UL, 2UL, 3UL, 4UL, 6UL, 7UL, 8UL, 9UL};
+const uint32_t APBPrescTable[8]  = {0UL, 0UL, 0UL, 0UL, 1UL, 2UL, 3UL, 4UL};
+
+HostRegs hostRegs;
+HostModel hostModel;
+HostWrite hostTrace[HOST_TRACE_MAX];
+uint32_t hostTraceLen   = 0;
+uint32_t hostPrimask    = 0;
+uint32_t hostIrqEnabled = 0;
+
+/**
+ * @brief Register whose changes end up in the trace
+ */
+typedef struct {
+  const char *name;
+  volatile uint32_t *reg;
+  uint32_t last;
+} HostTraced;
+
+static HostTraced traced[] = {
+    {"FLASH->ACR", &hostRegs.flash.ACR, 0},
+    {"RCC->CR", &hostRegs.rcc.CR, 0},
+    {"RCC->CFGR", &hostRegs.rcc.CFGR, 0},
+    {"RCC->PLLCFGR", &hostRegs.rcc.PLLCFGR, 0},
+    {"EXTI->IMR1", &hostRegs.exti.IMR1, 0},
+    {"PWR->CR1", &hostRegs.pwr.CR1, 0},
+    {"SCB->SCR", &hostRegs.scb.SCR, 0},
+    {"LPTIM1->CR", &hostRegs.lptim1.CR, 0},
+    {"LPTIM1->CMP", &hostRegs.lptim1.CMP, 0},
+    {"SysTick->CTRL", &hostRegs.systick.CTRL, 0},
+};
+
+#define HOST_TRACED (sizeof(traced) / sizeof(traced[0]))
+
+/**
+ * @brief Answers the last writes like the silicon would.
+ */
+static void Host_Model(void) {
+  RCC_TypeDef *rcc = &hostRegs.rcc;
+
+  rcc->CR   = (rcc->CR & ~RCC_CR_HSIRDY) | ((rcc->CR & RCC_CR_HSION) ? RCC_CR_HSIRDY : 0);
+  rcc->CR   = (rcc->CR & ~RCC_CR_PLLRDY) | (((rcc->CR & RCC_CR_PLLON) && !hostModel.pll_no_lock) ? RCC_CR_PLLRDY : 0);
+  rcc->CSR  = (rcc->CSR & ~RCC_CSR_LSIRDY) | ((rcc->CSR & RCC_CSR_LSION) ? RCC_CSR_LSIRDY : 0);
+  rcc->BDCR = (rcc->BDCR & ~RCC_BDCR_LSERDY) | ((rcc->BDCR & RCC_BDCR_LSEON) ? RCC_BDCR_LSERDY : 0);
+
+  if (!hostModel.refuse_switch)
+    rcc->CFGR = (rcc->CFGR & ~RCC_CFGR_SWS) | ((rcc->CFGR & RCC_CFGR_SW) << RCC_CFGR_SWS_Pos);
+
+  // ARR and CMP updates complete at once
+  if (hostRegs.lptim1.CR & LPTIM_CR_ENABLE)
+    hostRegs.lptim1.ISR |= LPTIM_ISR_ARROK | LPTIM_ISR_CMPOK;
+  else
+    hostRegs.lptim1.ISR = 0;
+
+  if (hostModel.step)
+    hostModel.step();
+}
+
+void Host_Sync(void) {
+  for (uint32_t i = 0; i < HOST_TRACED; i++) {
+    uint32_t value = *traced[i].reg;
+    if (value != traced[i].last && hostTraceLen < HOST_TRACE_MAX)
+      hostTrace[hostTraceLen++] = (HostWrite){traced[i].name, value};
+  }
+
+  Host_Model();
+
+  // The model's answers are not writes of the code under test
+  for (uint32_t i = 0; i < HOST_TRACED; i++)
+    traced[i].last = *traced[i].reg;
+}
+
+void *Host_Access(void *peripheral) {
+  Host_Sync();
+  return peripheral;
+}
+
+void Host_Reset(void) {
+  memset(&hostRegs, 0, sizeof(hostRegs));
+  memset(&hostModel, 0, sizeof(hostModel));
+
+  // Reset values from RM0444
+  hostRegs.rcc.CR      = RCC_CR_HSION | RCC_CR_HSIRDY;
+  hostRegs.rcc.PLLCFGR = 0x00001000UL;
+  hostRegs.flash.ACR   = FLASH_ACR_ICEN | FLASH_ACR_PRFTEN;
+
+  hostPrimask     = 0;
+  hostIrqEnabled  = 0;
+  SystemCoreClock = 16000000UL;
+
+  Host_Model();
+  for (uint32_t i = 0; i < HOST_TRACED; i++)
+    traced[i].last = *traced[i].reg;
+  hostTraceLen = 0;
+}
+
+void Host_TraceClear(void) {
+  Host_Sync();
+  hostTraceLen = 0;
+}
+
+int Host_TraceFind(const char *reg, uint32_t mask, uint32_t match, int from) {
+  for (int i = (from < 0) ? 0 : from; i < (int)hostTraceLen; i++)
+    if (!strcmp(hostTrace[i].reg, reg) && (hostTrace[i].value & mask) == match)
+      return i;
+
+  return -1;
+}
+
+uint32_t Host_TraceCount(const char *reg) {
+  uint32_t count = 0;
+
+  for (uint32_t i = 0; i < hostTraceLen; i++)
+    if (!strcmp(hostTrace[i].reg, reg))
+      count++;
+
+  return count;
+}
+
+void Host_TraceDump(void) {
+  for (uint32_t i = 0; i < hostTraceLen; i++)
+    printf("    %3u %-14s 0x%08X\n", (unsigned)i, hostTrace[i].reg, (unsigned)hostTrace[i].value);
+}
+
+void Host_WFI(void) {
+  Host_Sync();
+  if (hostModel.wfi)
+    hostModel.wfi();
+}
+
+void Host_EnableIRQ(IRQn_Type irq) {
+  hostIrqEnabled |= 1UL << irq;
+}
+
+void Host_DisableIRQ(IRQn_Type irq) {
+  hostIrqEnabled &= ~(1UL << irq);
+}
@@ -0,0 +1,107 @@
+/**
+ * @file    host.h
+ * @brief   Simulated STM32G031 peripherals for the host tests
+ * @author  Joshua
+ * @date    2025-11-02
+ *
+ * The peripherals live in hostRegs instead of at their bus addresses (see stm32g031xx.h next to
+ * this file). Every access from lib/ code first calls Host_Access, which
+ *  - records each change of a traced register, in program order, into hostTrace
+ *  - lets the simulated hardware answer: ready flags follow their enable bits, SWS follows SW,
+ *    the LPTIM1 register update flags are always set while it is enabled.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define HOST_TRACE_MAX 512    // Register changes kept per test
+
+/**
+ * @brief Peripherals used by lib/
+ */
+typedef struct {
+  RCC_TypeDef rcc;
+  FLASH_TypeDef flash;
+  PWR_TypeDef pwr;
+  EXTI_TypeDef exti;
+  GPIO_TypeDef gpioa, gpiob, gpioc, gpiod, gpiof;
+  LPTIM_TypeDef lptim1;
+  TIM_TypeDef tim2, tim3, tim16;
+  SPI_TypeDef spi1;
+  DMA_TypeDef dma1;
+  DMA_Channel_TypeDef dma1_ch2, dma1_ch3;
+  DMAMUX_Channel_TypeDef dmamux1_ch1, dmamux1_ch2;
+  RTC_TypeDef rtc;
+  SysTick_Type systick;
+  SCB_Type scb;
+} HostRegs;
+
+/**
+ * @brief One recorded register change
+ */
+typedef struct {
+  const char *reg;    // e.g. "RCC->CFGR"
+  uint32_t value;     // Value after the write
+} HostWrite;
+
+/**
+ * @brief Knobs of the simulated hardware
+ */
+typedef struct {
+  bool refuse_switch;    // SWS ignores SW, e.g. a source that never becomes ready
+  bool pll_no_lock;      // PLLRDY never follows PLLON
+  void (*wfi)(void);     // Runs on __WFI, e.g. to advance simulated time or fire an interrupt
+  void (*step)(void);    // Runs on every peripheral access, e.g. to let the SPI shifter move on
+} HostModel;
+
+extern HostRegs hostRegs;
+extern HostModel hostModel;
+extern HostWrite hostTrace[HOST_TRACE_MAX];
+extern uint32_t hostTraceLen;
+extern uint32_t hostPrimask;
+extern uint32_t hostIrqEnabled;
+
+/**
+ * @brief Puts every register back to its reset value and clears the trace and the model knobs.
+ */
+void Host_Reset(void);
+
+/**
+ * @brief Records the changes since the last access and runs the hardware model.
+ * Note:
+ *  Called by every peripheral access, call it once more after the code under test returns so
+ *  its last write is recorded.
+ */
+void Host_Sync(void);
+
+/**
+ * @brief Peripheral access hook used by the register macros.
+ */
+void *Host_Access(void *peripheral);
+
+/**
+ * @brief Forgets the recorded changes.
+ */
+void Host_TraceClear(void);
+
+/**
+ * @brief Finds the first recorded write of @p reg at or after @p from with (value & mask) == match.
+ * @return Trace index, or -1 if there is none.
+ */
+int Host_TraceFind(const char *reg, uint32_t mask, uint32_t match, int from);
+
+/**
+ * @brief Counts the recorded writes of @p reg.
+ */
+uint32_t Host_TraceCount(const char *reg);
+
+/**
+ * @brief Prints the trace, for debugging a failing test.
+ */
+void Host_TraceDump(void);
+
+void Host_WFI(void);
+void Host_EnableIRQ(IRQn_Type irq);
+void Host_DisableIRQ(IRQn_Type irq);
@@ -0,0 +1,151 @@
+/**
+ * @file    spi1.c
+ * @brief   Simulated SPI1 FIFOs and shifter for the host tests and benchmarks
+ * @author  Joshua
+ * @date    2025-11-02
+ */
+
+#include "spi1.h"
+
+#include <string.h>
+
+HostSpi hostSpi;
+
+/**
+ * @brief CPU cycles one byte takes on the wire.
+ */
+static uint32_t HostSpi_ByteCycles(void) {
+  uint32_t br = (hostRegs.spi1.CR1 & SPI_CR1_BR) >> SPI_CR1_BR_Pos;
+  return 8UL << (br + 1);
+}
+
+/**
+ * @brief Mirrors the FIFO levels into SR.
+ */
+static void HostSpi_UpdateSR(void) {
+  uint8_t threshold = (hostRegs.spi1.CR2 & SPI_CR2_FRXTH) ? 1 : 2;
+  uint32_t sr       = hostRegs.spi1.SR & SPI_SR_OVR;
+
+  if (hostSpi.tx_level <= HOST_SPI_FIFO / 2)
+    sr |= SPI_SR_TXE;
+  if (hostSpi.rx_level >= threshold)
+    sr |= SPI_SR_RXNE;
+  if (hostSpi.shifting || hostSpi.tx_level)
+    sr |= SPI_SR_BSY;
+
+  sr |= (uint32_t)((hostSpi.tx_level > 3) ? 3 : hostSpi.tx_level) << SPI_SR_FTLVL_Pos;
+  sr |= (uint32_t)((hostSpi.rx_level > 3) ? 3 : hostSpi.rx_level) << SPI_SR_FRLVL_Pos;
+  hostRegs.spi1.SR = sr;
+}
+
+/**
+ * @brief Runs the shifter one CPU cycle.
+ */
+static void HostSpi_Cycle(void) {
+  hostSpi.cycles++;
+
+  if (hostSpi.shifting && hostSpi.cycles >= hostSpi.shift_end) {
+    hostSpi.shifting = false;
+    hostSpi.last_end = hostSpi.cycles;
+
+    if (hostSpi.rx_level < HOST_SPI_FIFO) {
+      hostSpi.rx[hostSpi.rx_level++] = (uint8_t)~hostSpi.shift_byte;
+    } else {
+      hostSpi.overruns++;
+      hostRegs.spi1.SR |= SPI_SR_OVR;
+    }
+  }
+
+  if (!hostSpi.shifting && hostSpi.tx_level && (hostRegs.spi1.CR1 & SPI_CR1_SPE)) {
+    if (hostSpi.bytes)
+      hostSpi.gap_cycles += hostSpi.cycles - hostSpi.last_end;
+
+    hostSpi.shift_byte = hostSpi.tx[0];
+    memmove(hostSpi.tx, hostSpi.tx + 1, --hostSpi.tx_level);
+    hostSpi.shifting  = true;
+    hostSpi.shift_end = hostSpi.cycles + HostSpi_ByteCycles();
+    hostSpi.bytes++;
+  }
+}
+
+/**
+ * @brief hostModel.step, one peripheral access worth of time.
+ */
+static void HostSpi_Step(void) {
+  hostSpi.accesses++;
+  HostSpi_Advance(hostSpi.access_cycles);
+}
+
+void HostSpi_Reset(uint32_t access_cycles) {
+  memset(&hostSpi, 0, sizeof(hostSpi));
+  hostSpi.access_cycles = access_cycles;
+  hostModel.step        = HostSpi_Step;
+  HostSpi_UpdateSR();
+}
+
+void HostSpi_Advance(uint32_t cycles) {
+  while (cycles--)
+    HostSpi_Cycle();
+
+  HostSpi_UpdateSR();
+}
+
+/**
+ * @brief Logs a DR access and charges its time.
+ */
+static void HostSpi_Log(bool write, uint8_t width) {
+  hostSpi.accesses++;
+  HostSpi_Advance(hostSpi.access_cycles);
+
+  if (hostSpi.log_len < HOST_SPI_LOG)
+    hostSpi.log[hostSpi.log_len++] = (HostSpiAccess){write, width, (hostRegs.spi1.CR2 & SPI_CR2_FRXTH) != 0};
+}
+
+uint16_t HostSpi_Read(uint8_t width) {
+  HostSpi_Log(false, width);
+
+  uint8_t count = width / 8;
+  if (hostSpi.rx_level < count) {
+    hostSpi.bad_accesses++;
+    return 0;
+  }
+
+  uint16_t value = hostSpi.rx[0];
+  if (count == 2)
+    value |= (uint16_t)(hostSpi.rx[1] << 8);
+
+  hostSpi.rx_level -= count;
+  memmove(hostSpi.rx, hostSpi.rx + count, hostSpi.rx_level);
+  HostSpi_UpdateSR();
+  return value;
+}
+
+void HostSpi_Write(uint8_t width, uint16_t value) {
+  HostSpi_Log(true, width);
+
+  uint8_t count = width / 8;
+  if (hostSpi.tx_level + count > HOST_SPI_FIFO) {
+    hostSpi.bad_accesses++;
+    return;
+  }
+
+  hostSpi.tx[hostSpi.tx_level++] = (uint8_t)value;
+  if (count == 2)
+    hostSpi.tx[hostSpi.tx_level++] = (uint8_t)(value >> 8);
+
+  uint8_t inflight = hostSpi.tx_level + hostSpi.shifting + hostSpi.rx_level;
+  if (inflight > hostSpi.max_inflight)
+    hostSpi.max_inflight = inflight;
+
+  HostSpi_UpdateSR();
+}
+
+uint32_t HostSpi_Count(bool write, uint8_t width, bool frxth) {
+  uint32_t count = 0;
+
+  for (uint32_t i = 0; i < hostSpi.log_len; i++)
+    if (hostSpi.log[i].write == write && hostSpi.log[i].width == width && hostSpi.log[i].frxth == frxth)
+      count++;
+
+  return count;
+}
@@ -0,0 +1,85 @@
+/**
+ * @file    spi1.h
+ * @brief   Simulated SPI1 FIFOs and shifter for the host tests and benchmarks
+ * @author  Joshua
+ * @date    2025-11-02
+ *
+ * Time is counted in CPU cycles with PCLK = HCLK: every peripheral access of the code under test
+ * costs access_cycles, SCK runs at PCLK / 2^(BR + 1) from hostRegs.spi1.CR1. Bytes written to DR
+ * wait in the 4-byte TX FIFO, shift out back to back while there is data, and come back on MISO
+ * inverted into the 4-byte RX FIFO. SR (TXE, RXNE after FRXTH, FTLVL, FRLVL, BSY, OVR) follows
+ * after every step.
+ *
+ * spi.c is included by the test with its DR accessors replaced by HostSpi_Read / HostSpi_Write,
+ * which log the access size and the FRXTH setting each read was made with.
+ */
+
+#pragma once
+
+#include <stm32g031xx.h>
+
+#define HOST_SPI_FIFO 4      // Bytes per FIFO
+#define HOST_SPI_LOG 256     // DR accesses kept
+
+/**
+ * @brief One DR access of the code under test
+ */
+typedef struct {
+  bool write;
+  uint8_t width;    // 8 or 16 bits
+  bool frxth;       // CR2.FRXTH at the time of the access
+} HostSpiAccess;
+
+/**
+ * @brief State of the simulated SPI1
+ */
+typedef struct {
+  uint32_t access_cycles;    // CPU cycles charged per peripheral access
+  uint32_t cycles;           // CPU cycles elapsed since HostSpi_Reset
+  uint32_t accesses;         // Peripheral accesses charged
+
+  uint8_t tx[HOST_SPI_FIFO];
+  uint8_t rx[HOST_SPI_FIFO];
+  uint8_t tx_level;
+  uint8_t rx_level;
+  bool shifting;
+  uint8_t shift_byte;
+  uint32_t shift_end;
+
+  uint32_t bytes;           // Bytes shifted
+  uint32_t gap_cycles;      // SCK idle between two bytes, summed
+  uint32_t last_end;        // Cycle the last byte finished
+  uint8_t max_inflight;     // Most bytes written and not yet read at any time
+  uint32_t overruns;        // Bytes lost on a full RX FIFO
+  uint32_t bad_accesses;    // Reads of a too empty RX FIFO, writes to a too full TX FIFO
+
+  HostSpiAccess log[HOST_SPI_LOG];
+  uint32_t log_len;
+} HostSpi;
+
+extern HostSpi hostSpi;
+
+/**
+ * @brief Empties the FIFOs and the log, installs the model as hostModel.step. Call after Host_Reset.
+ */
+void HostSpi_Reset(uint32_t access_cycles);
+
+/**
+ * @brief Lets @p cycles CPU cycles pass outside the code under test, e.g. idle or interrupt entry.
+ */
+void HostSpi_Advance(uint32_t cycles);
+
+/**
+ * @brief DR read of @p width bits, pops one or two bytes.
+ */
+uint16_t HostSpi_Read(uint8_t width);
+
+/**
+ * @brief DR write of @p width bits, pushes one or two bytes.
+ */
+void HostSpi_Write(uint8_t width, uint16_t value);
+
+/**
+ * @brief Counts the logged DR accesses matching the direction, width and FRXTH setting.
+ */
+uint32_t HostSpi_Count(bool write, uint8_t width, bool frxth);
@@ -0,0 +1,77 @@
+/**
+ * @file    stm32g031xx.h
+ * @brief   Host build of the device header, with the peripherals moved into hostRegs
+ * @author  Joshua
+ * @date    2025-11-02
+ *
+ * Found before STM32G0xx/Device/Include in the host test include path, so lib/ sources compile
+ * unchanged. The CMSIS intrinsics that would execute ARM instructions are replaced as well.
+ */
+
+#pragma once
+
+#include_next "stm32g031xx.h"
+
+#include "host.h"
+
+#undef RCC
+#undef FLASH
+#undef PWR
+#undef EXTI
+#undef GPIOA
+#undef GPIOB
+#undef GPIOC
+#undef GPIOD
+#undef GPIOF
+#undef LPTIM1
+#undef TIM2
+#undef TIM3
+#undef TIM16
+#undef SPI1
+#undef DMA1
+#undef DMA1_Channel2
+#undef DMA1_Channel3
+#undef DMAMUX1_Channel1
+#undef DMAMUX1_Channel2
+#undef RTC
+#undef SysTick
+#undef SCB
+
+#define RCC ((RCC_TypeDef *)Host_Access(&hostRegs.rcc))
+#define FLASH ((FLASH_TypeDef *)Host_Access(&hostRegs.flash))
+#define PWR ((PWR_TypeDef *)Host_Access(&hostRegs.pwr))
+#define EXTI ((EXTI_TypeDef *)Host_Access(&hostRegs.exti))
+#define GPIOA ((GPIO_TypeDef *)Host_Access(&hostRegs.gpioa))
+#define GPIOB ((GPIO_TypeDef *)Host_Access(&hostRegs.gpiob))
+#define GPIOC ((GPIO_TypeDef *)Host_Access(&hostRegs.gpioc))
+#define GPIOD ((GPIO_TypeDef *)Host_Access(&hostRegs.gpiod))
+#define GPIOF ((GPIO_TypeDef *)Host_Access(&hostRegs.gpiof))
+#define LPTIM1 ((LPTIM_TypeDef *)Host_Access(&hostRegs.lptim1))
+#define TIM2 ((TIM_TypeDef *)Host_Access(&hostRegs.tim2))
+#define TIM3 ((TIM_TypeDef *)Host_Access(&hostRegs.tim3))
+#define TIM16 ((TIM_TypeDef *)Host_Access(&hostRegs.tim16))
+#define SPI1 ((SPI_TypeDef *)Host_Access(&hostRegs.spi1))
+#define DMA1 ((DMA_TypeDef *)Host_Access(&hostRegs.dma1))
+#define DMA1_Channel2 ((DMA_Channel_TypeDef *)Host_Access(&hostRegs.dma1_ch2))
+#define DMA1_Channel3 ((DMA_Channel_TypeDef *)Host_Access(&hostRegs.dma1_ch3))
+#define DMAMUX1_Channel1 ((DMAMUX_Channel_TypeDef *)Host_Access(&hostRegs.dmamux1_ch1))
+#define DMAMUX1_Channel2 ((DMAMUX_Channel_TypeDef *)Host_Access(&hostRegs.dmamux1_ch2))
+#define RTC ((RTC_TypeDef *)Host_Access(&hostRegs.rtc))
+#define SysTick ((SysTick_Type *)Host_Access(&hostRegs.systick))
+#define SCB ((SCB_Type *)Host_Access(&hostRegs.scb))
+
+// Core intrinsics
+#undef __WFI
+#define __WFI() Host_WFI()
+#define __DSB() ((void)0)
+#define __disable_irq() (hostPrimask = 1)
+#define __enable_irq() (hostPrimask = 0)
+#define __get_PRIMASK() (hostPrimask)
+#define __set_PRIMASK(value) (hostPrimask = (value))
+
+#undef NVIC_EnableIRQ
+#undef NVIC_DisableIRQ
+#undef NVIC_SetPriority
+#define NVIC_EnableIRQ(irq) Host_EnableIRQ(irq)
+#define NVIC_DisableIRQ(irq) Host_DisableIRQ(irq)
+#define NVIC_SetPriority(irq, priority) ((void)(irq), (void)(priority))
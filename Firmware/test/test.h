@@ -0,0 +1,47 @@
+/**
+ * @file    test.h
+ * @brief   Minimal check macros for the host tests
+ * @author  Joshua
+ * @date    2025-11-02
+ */
+
+#pragma once
+
+#include <stdio.h>
+
+static int testFailures = 0;
+
+/**
+ * @brief Reports a failed condition and keeps going.
+ */
+#define CHECK(cond)                                                                                           \
+  do {                                                                                                        \
+    if (!(cond)) {                                                                                            \
+      printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond);                                         \
+      testFailures++;                                                                                         \
+    }                                                                                                         \
+  } while (0)
+
+/**
+ * @brief Reports two different integers.
+ */
+#define CHECK_EQ(actual, expected)                                                                            \
+  do {                                                                                                        \
+    long long a_ = (long long)(actual);                                                                       \
+    long long e_ = (long long)(expected);                                                                     \
+    if (a_ != e_) {                                                                                           \
+      printf("%s:%d: %s is %lld, expected %lld\n", __FILE__, __LINE__, #actual, a_, e_);                      \
+      testFailures++;                                                                                         \
+    }                                                                                                         \
+  } while (0)
+
+#define TEST_RUN(fn)                                                                                          \
+  do {                                                                                                        \
+    printf("  %s\n", #fn);                                                                                    \
+    fn();                                                                                                     \
+  } while (0)
+
+/**
+ * @brief Prints the result line, use as the return value of main.
+ */
+#define TEST_RESULT(name) (printf("%s: %s\n", (name), testFailures ? "FAILED" : "ok"), testFailures ? 1 : 0)
@@ -0,0 +1,167 @@
+/**
+ * @file    test_button.c
+ * @brief   Host test of the button debouncer with recorded bounce traces
+ * @author  Joshua
+ * @date    2025-11-02
+ *
+ * Each trace is one raw sample per BUTTON_SAMPLE_MS, '#' pressed and '.' released. The events are
+ * collected with the index of the sample that produced them.
+ */
+
+#include <string.h>
+
+#include "button.h"
+#include "pins.h"
+#include "stm32g031xx.h"
+#include "test.h"
+
+#define BUTTON_MASK (PIN_BTN_PLAY_MASK | PIN_BTN_NEXT_MASK | PIN_BTN_BACK_MASK)
+#define LONG_SAMPLES (BUTTON_LONG_MS / BUTTON_SAMPLE_MS)
+#define REPEAT_SAMPLES (BUTTON_REPEAT_MS / BUTTON_SAMPLE_MS)
+
+/**
+ * @brief One event and the sample it came from
+ */
+typedef struct {
+  uint32_t sample;
+  uint8_t pin;
+  ButtonEventType type;
+} Logged;
+
+static Logged logged[64];
+static uint32_t loggedCount;
+
+/**
+ * @brief Drains the queue into the log.
+ */
+static void Collect(uint32_t sample) {
+  ButtonEvent event;
+
+  while (Button_GetEvent(&event))
+    if (loggedCount < sizeof(logged) / sizeof(logged[0]))
+      logged[loggedCount++] = (Logged){sample, event.pin, event.type};
+}
+
+/**
+ * @brief Feeds a trace for one pin, starting at sample @p first.
+ */
+static uint32_t Feed(const char *trace, uint8_t pin, uint32_t first) {
+  uint32_t n = (uint32_t)strlen(trace);
+
+  for (uint32_t i = 0; i < n; i++) {
+    Button_Sample(trace[i] == '#' ? (uint16_t)(1U << pin) : 0);
+    Collect(first + i);
+  }
+
+  return first + n;
+}
+
+static void Setup(void) {
+  Host_Reset();
+  Button_Init(GPIOB, BUTTON_MASK);
+  loggedCount = 0;
+}
+
+static void TestBouncyPressAndRelease(void) {
+  Setup();
+
+  // Contact bounce on both edges, then stable for a while
+  Feed("..#.#.##.####" "#######" "#.#..#..." "......", PIN_BTN_PLAY_NUM, 0);
+
+  CHECK_EQ(loggedCount, 2);
+  CHECK_EQ(logged[0].type, BUTTON_EVENT_PRESS);
+  CHECK_EQ(logged[0].pin, PIN_BTN_PLAY_NUM);
+  CHECK_EQ(logged[0].sample, 11);    // Third pressed sample of the first stable run
+  CHECK_EQ(logged[1].type, BUTTON_EVENT_RELEASE);
+  CHECK_EQ(logged[1].sample, 28);
+  CHECK_EQ(Button_GetState(), 0);
+}
+
+static void TestGlitchesAreIgnored(void) {
+  Setup();
+
+  // Single and double sample spikes, e.g. from the encoder switching next to the buttons
+  Feed("...#....##...#.#.##..", PIN_BTN_NEXT_NUM, 0);
+
+  CHECK_EQ(loggedCount, 0);
+  CHECK_EQ(Button_GetState(), 0);
+}
+
+static void TestLongPressAndRepeat(void) {
+  Setup();
+
+  uint32_t n = Feed("###", PIN_BTN_NEXT_NUM, 0);
+  for (uint32_t i = 0; i < LONG_SAMPLES + 2 * REPEAT_SAMPLES; i++)
+    n = Feed("#", PIN_BTN_NEXT_NUM, n);
+  Feed("...", PIN_BTN_NEXT_NUM, n);
+
+  CHECK_EQ(loggedCount, 5);
+  CHECK_EQ(logged[0].type, BUTTON_EVENT_PRESS);
+  CHECK_EQ(logged[1].type, BUTTON_EVENT_LONG);
+  CHECK_EQ(logged[1].sample - logged[0].sample, LONG_SAMPLES);
+  CHECK_EQ(logged[2].type, BUTTON_EVENT_REPEAT);
+  CHECK_EQ(logged[2].sample - logged[1].sample, REPEAT_SAMPLES);
+  CHECK_EQ(logged[3].type, BUTTON_EVENT_REPEAT);
+  CHECK_EQ(logged[3].sample - logged[2].sample, REPEAT_SAMPLES);
+  CHECK_EQ(logged[4].type, BUTTON_EVENT_RELEASE);
+}
+
+static void TestHeldCountersAreIndependent(void) {
+  Setup();
+
+  // PLAY held throughout, NEXT pressed 100 samples later with some bounce
+  uint16_t play = PIN_BTN_PLAY_MASK;
+  uint16_t next = PIN_BTN_NEXT_MASK;
+  for (uint32_t i = 0; i < 3 + LONG_SAMPLES + 120; i++) {
+    uint16_t raw = play;
+    if (i >= 100)
+      raw |= (i == 101) ? 0 : next;
+    Button_Sample(raw);
+    Collect(i);
+  }
+
+  uint32_t play_press = 0, play_long = 0, next_press = 0, next_long = 0, longs = 0;
+  for (uint32_t i = 0; i < loggedCount; i++) {
+    if (logged[i].type == BUTTON_EVENT_LONG)
+      longs++;
+    if (logged[i].pin == PIN_BTN_PLAY_NUM && logged[i].type == BUTTON_EVENT_PRESS)
+      play_press = logged[i].sample;
+    if (logged[i].pin == PIN_BTN_PLAY_NUM && logged[i].type == BUTTON_EVENT_LONG)
+      play_long = logged[i].sample;
+    if (logged[i].pin == PIN_BTN_NEXT_NUM && logged[i].type == BUTTON_EVENT_PRESS)
+      next_press = logged[i].sample;
+    if (logged[i].pin == PIN_BTN_NEXT_NUM && logged[i].type == BUTTON_EVENT_LONG)
+      next_long = logged[i].sample;
+  }
+
+  // Each button keeps its own timing, one LONG each
+  CHECK_EQ(longs, 2);
+  CHECK_EQ(play_long - play_press, LONG_SAMPLES);
+  CHECK_EQ(next_long - next_press, LONG_SAMPLES);
+}
+
+static void TestPollReadsActiveLow(void) {
+  Setup();
+
+  // Pull-ups: all high, BACK pulled low
+  hostRegs.gpiob.IDR = 0xFFFF & ~PIN_BTN_BACK_MASK;
+  for (uint32_t i = 0; i < 3; i++)
+    Button_Poll();
+
+  CHECK_EQ(Button_GetState(), PIN_BTN_BACK_MASK);
+
+  ButtonEvent event;
+  CHECK(Button_GetEvent(&event));
+  CHECK_EQ(event.pin, PIN_BTN_BACK_NUM);
+  CHECK_EQ(event.type, BUTTON_EVENT_PRESS);
+}
+
+int main(void) {
+  TEST_RUN(TestBouncyPressAndRelease);
+  TEST_RUN(TestGlitchesAreIgnored);
+  TEST_RUN(TestLongPressAndRepeat);
+  TEST_RUN(TestHeldCountersAreIndependent);
+  TEST_RUN(TestPollReadsActiveLow);
+
+  return TEST_RESULT("test_button");
+}
@@ -0,0 +1,269 @@
+/**
+ * @file    test_clock.c
+ * @brief   Host tests of the SYSCLK switch register sequence and the wakeup setup in clock.c
+ * @author  Joshua
+ * @date    2025-11-02
+ *
+ * The flash must never be read with fewer wait states than HCLK needs: FLASH->ACR goes up before
+ * RCC->CFGR.SW on an upshift, and comes down only after it on a downshift.
+ */
+
+#include "clock.h"
+#include "clock_pll.h"
+#include "stm32g031xx.h"
+#include "test.h"
+
+#define ACR_LATENCY(ws) ((uint32_t)(ws) << FLASH_ACR_LATENCY_Pos)
+#define CFGR_SW(src) ((uint32_t)(src) << RCC_CFGR_SW_Pos)
+
+CLOCK_PLL_DEFINE(pll64, 64000000UL, 0, 0);
+CLOCK_PLL_DEFINE(pll48, 48000000UL, 0, 0);
+
+/**
+ * @brief Resets the simulated chip and locks the 64 MHz PLL, SYSCLK still on HSI16.
+ */
+static void Setup(void) {
+  Host_Reset();
+  CHECK(Clock_SetSystemClock(SYSCLK_SRC_HSISYS));
+  CHECK(Clock_ConfigurePLL(&pll64));
+  Host_TraceClear();
+}
+
+static void TestUpshiftRaisesLatencyFirst(void) {
+  Setup();
+
+  CHECK(Clock_SetSystemClock(SYSCLK_SRC_PLLRCLK));
+  Host_Sync();
+
+  int latency = Host_TraceFind("FLASH->ACR", FLASH_ACR_LATENCY, ACR_LATENCY(2), 0);
+  int sw      = Host_TraceFind("RCC->CFGR", RCC_CFGR_SW, CFGR_SW(SYSCLK_SRC_PLLRCLK), 0);
+  CHECK(latency >= 0);
+  CHECK(sw > latency);
+
+  // Never lowered again on the way
+  CHECK(Host_TraceFind("FLASH->ACR", FLASH_ACR_LATENCY, ACR_LATENCY(0), latency) < 0);
+  CHECK(Host_TraceFind("FLASH->ACR", FLASH_ACR_LATENCY, ACR_LATENCY(1), latency) < 0);
+
+  CHECK_EQ(Clock_GetSYSCLK(), 64000000UL);
+  CHECK_EQ(Clock_GetHCLK(), 64000000UL);
+  CHECK_EQ(SystemCoreClock, 64000000UL);
+  CHECK_EQ(hostRegs.flash.ACR & FLASH_ACR_LATENCY, ACR_LATENCY(2));
+  CHECK(hostRegs.flash.ACR & FLASH_ACR_ICEN);
+  CHECK(hostRegs.flash.ACR & FLASH_ACR_PRFTEN);
+
+  if (testFailures)
+    Host_TraceDump();
+}
+
+static void TestDownshiftLowersLatencyAfter(void) {
+  Setup();
+  CHECK(Clock_SetSystemClock(SYSCLK_SRC_PLLRCLK));
+  Host_TraceClear();
+
+  CHECK(Clock_SetSystemClock(SYSCLK_SRC_HSISYS));
+  Host_Sync();
+
+  int sw      = Host_TraceFind("RCC->CFGR", RCC_CFGR_SW, CFGR_SW(SYSCLK_SRC_HSISYS), 0);
+  int latency = Host_TraceFind("FLASH->ACR", FLASH_ACR_LATENCY, ACR_LATENCY(0), 0);
+  CHECK(sw >= 0);
+  CHECK(latency > sw);
+
+  CHECK_EQ(Clock_GetSYSCLK(), 16000000UL);
+  CHECK_EQ(hostRegs.flash.ACR & FLASH_ACR_LATENCY, ACR_LATENCY(0));
+}
+
+static void TestPrescalerCountsForLatency(void) {
+  Setup();
+  CHECK(Clock_SetSystemClock(SYSCLK_SRC_PLLRCLK));
+  Host_TraceClear();
+
+  // 64 MHz / 2 = 32 MHz HCLK needs one wait state, lowered only once HPRE is written
+  CHECK(Clock_SetBusDividers(&(ClockBusConfig){.ahb_div = 2, .apb1_div = 1, .apb2_div = 1}));
+  Host_Sync();
+
+  int presc   = Host_TraceFind("RCC->CFGR", RCC_CFGR_HPRE, 0x8UL << RCC_CFGR_HPRE_Pos, 0);
+  int latency = Host_TraceFind("FLASH->ACR", FLASH_ACR_LATENCY, ACR_LATENCY(1), 0);
+  CHECK(presc >= 0);
+  CHECK(latency > presc);
+  CHECK_EQ(Clock_GetHCLK(), 32000000UL);
+
+  // And back up to 64 MHz: latency first
+  Host_TraceClear();
+  CHECK(Clock_SetBusDividers(&(ClockBusConfig){.ahb_div = 1, .apb1_div = 1, .apb2_div = 1}));
+  Host_Sync();
+
+  latency = Host_TraceFind("FLASH->ACR", FLASH_ACR_LATENCY, ACR_LATENCY(2), 0);
+  presc   = Host_TraceFind("RCC->CFGR", RCC_CFGR_HPRE, 0, 0);
+  CHECK(latency >= 0);
+  CHECK(presc > latency);
+}
+
+static void TestRefusedSwitchRestores(void) {
+  Setup();
+  hostModel.refuse_switch = true;
+
+  CHECK(!Clock_SetSystemClock(SYSCLK_SRC_PLLRCLK));
+  Host_Sync();
+
+  // SW and the wait states are put back, the cached tree never moved
+  CHECK_EQ(hostRegs.rcc.CFGR & RCC_CFGR_SW, CFGR_SW(SYSCLK_SRC_HSISYS));
+  CHECK_EQ(hostRegs.flash.ACR & FLASH_ACR_LATENCY, ACR_LATENCY(0));
+  CHECK_EQ(Clock_GetSYSCLK(), 16000000UL);
+}
+
+static void TestUnlockedPLLIsRejected(void) {
+  Host_Reset();
+  CHECK(Clock_SetSystemClock(SYSCLK_SRC_HSISYS));
+  Host_TraceClear();
+
+  CHECK(!Clock_SetSystemClock(SYSCLK_SRC_PLLRCLK));
+  Host_Sync();
+
+  CHECK_EQ(Host_TraceCount("RCC->CFGR"), 0);
+  CHECK_EQ(Host_TraceCount("FLASH->ACR"), 0);
+}
+
+static void TestWakeupKeepsAttachedLines(void) {
+  Host_Reset();
+
+  // DREQ (line 1) and a button (line 5) attached by their drivers
+  hostRegs.exti.IMR1 = EXTI_IMR1_IM1 | EXTI_IMR1_IM5;
+
+  CHECK(Clock_ConfigureWakeup(CLOCK_WAKE_EXTI | CLOCK_WAKE_LPTIM, EXTI_IMR1_IM4 | EXTI_IMR1_IM5));
+  CHECK_EQ(hostRegs.exti.IMR1, EXTI_IMR1_IM1 | EXTI_IMR1_IM4 | EXTI_IMR1_IM5 | EXTI_IMR1_IM29);
+
+  // Only line 4 and LPTIM1 were unmasked here, so only they are masked again
+  CHECK(Clock_ConfigureWakeup(CLOCK_WAKE_RTC, 0));
+  CHECK_EQ(hostRegs.exti.IMR1, EXTI_IMR1_IM1 | EXTI_IMR1_IM5 | EXTI_IMR1_IM19);
+}
+
+static void TestStopNeedsAWakeSource(void) {
+  Host_Reset();
+  CHECK(Clock_ConfigureWakeup(CLOCK_WAKE_EXTI, EXTI_IMR1_IM5));
+  Host_TraceClear();
+
+  // The caller's deadline rests on LPTIM1, which cannot wake the core
+  CHECK(!Clock_EnterStopMode(CLOCK_WAKE_LPTIM));
+  Host_Sync();
+  CHECK_EQ(Host_TraceCount("SCB->SCR"), 0);
+
+  // Enabled, but its line masked again by another driver
+  CHECK(Clock_ConfigureWakeup(CLOCK_WAKE_LPTIM, 0));
+  hostRegs.exti.IMR1 &= ~EXTI_IMR1_IM29;
+  CHECK_EQ(Clock_GetWakeup(), 0);
+  CHECK(!Clock_EnterStopMode(CLOCK_WAKE_LPTIM));
+
+  hostRegs.exti.IMR1 |= EXTI_IMR1_IM29;
+  CHECK_EQ(Clock_GetWakeup(), CLOCK_WAKE_LPTIM);
+  CHECK(Clock_EnterStopMode(CLOCK_WAKE_LPTIM));
+  Host_Sync();
+  CHECK(Host_TraceFind("SCB->SCR", SCB_SCR_SLEEPDEEP_Msk, SCB_SCR_SLEEPDEEP_Msk, 0) >= 0);
+  CHECK_EQ(hostRegs.scb.SCR & SCB_SCR_SLEEPDEEP_Msk, 0);
+}
+
+static void TestEconomyStopsPLL(void) {
+  Setup();
+  CHECK(Clock_ApplyProfile(CLOCK_PROFILE_MAX_THROUGHPUT));
+  Host_TraceClear();
+
+  CHECK(Clock_ApplyProfile(CLOCK_PROFILE_PLAYBACK_ECONOMY));
+  Host_Sync();
+
+  // PLL off only once SYSCLK runs from HSISYS
+  int sw  = Host_TraceFind("RCC->CFGR", RCC_CFGR_SW, CFGR_SW(SYSCLK_SRC_HSISYS), 0);
+  int off = Host_TraceFind("RCC->CR", RCC_CR_PLLON, 0, 0);
+  CHECK(sw >= 0);
+  CHECK(off > sw);
+  CHECK_EQ(hostRegs.rcc.CR & (RCC_CR_PLLON | RCC_CR_PLLRDY), 0);
+  CHECK_EQ(Clock_GetHCLK(), 16000000UL);
+
+  CHECK(Clock_ApplyProfile(CLOCK_PROFILE_IDLE));
+  CHECK_EQ(Clock_GetHCLK(), 1000000UL);
+}
+
+static void TestMaxReplacesForeignPLL(void) {
+  Host_Reset();
+  CHECK(Clock_ConfigurePLL(&pll48));
+  CHECK(Clock_SetSystemClock(SYSCLK_SRC_PLLRCLK));
+  CHECK_EQ(Clock_GetSYSCLK(), 48000000UL);
+  Host_TraceClear();
+
+  CHECK(Clock_ApplyProfile(CLOCK_PROFILE_MAX_THROUGHPUT));
+  Host_Sync();
+
+  // Off the 48 MHz PLL before it is reprogrammed, then onto the 64 MHz plan
+  int hsi   = Host_TraceFind("RCC->CFGR", RCC_CFGR_SW, CFGR_SW(SYSCLK_SRC_HSISYS), 0);
+  int plan  = Host_TraceFind("RCC->PLLCFGR", 0xFFFFFFFFUL, hostRegs.rcc.PLLCFGR, 0);
+  int pll64 = Host_TraceFind("RCC->CFGR", RCC_CFGR_SW, CFGR_SW(SYSCLK_SRC_PLLRCLK), hsi);
+  CHECK(hsi >= 0);
+  CHECK(plan > hsi);
+  CHECK(pll64 > plan);
+  CHECK_EQ(Clock_GetSYSCLK(), 64000000UL);
+
+  // Already on the plan: no PLL writes at all
+  Host_TraceClear();
+  CHECK(Clock_ApplyProfile(CLOCK_PROFILE_MAX_THROUGHPUT));
+  Host_Sync();
+  CHECK_EQ(Host_TraceCount("RCC->PLLCFGR"), 0);
+  CHECK_EQ(Host_TraceCount("RCC->CR"), 0);
+}
+
+void TIM16_IRQHandler(void);
+
+static uint16_t trimCapture;
+
+/**
+ * @brief Feeds TIM16 captures @p ticks timer counts apart to the background trimming.
+ */
+static void TrimCaptures(uint32_t count, uint32_t ticks) {
+  for (uint32_t i = 0; i < count; i++) {
+    trimCapture += (uint16_t)ticks;
+    hostRegs.tim16.CCR1 = trimCapture;
+    hostRegs.tim16.SR |= TIM_SR_CC1IF;
+    TIM16_IRQHandler();
+  }
+}
+
+static void TestTrimRestartsOnClockChange(void) {
+  Setup();
+  hostRegs.rcc.BDCR |= RCC_BDCR_LSEON;
+  hostRegs.rcc.CSR |= RCC_CSR_LSION;
+  hostRegs.rcc.ICSCR = 64UL << RCC_ICSCR_HSITRIM_Pos;
+  CHECK(Clock_StartHSITrim());
+
+  // Eight LSE periods are 3906.25 counts at 16 MHz and 15625 at 64 MHz, a perfect HSI16 either way
+  TrimCaptures(10, 3906);
+  CHECK(Clock_ApplyProfile(CLOCK_PROFILE_MAX_THROUGHPUT));
+  TrimCaptures(33, 15625);
+  CHECK_EQ(hostRegs.rcc.ICSCR & RCC_ICSCR_HSITRIM, 64UL << RCC_ICSCR_HSITRIM_Pos);
+  CHECK_EQ(Clock_GetHSIError(), 0);
+
+  // From the LSI, TIM16 counts nothing related to HSI16
+  CHECK(Clock_SetSystemClock(SYSCLK_SRC_LSI));
+  TrimCaptures(40, 8);
+  CHECK_EQ(hostRegs.rcc.ICSCR & RCC_ICSCR_HSITRIM, 64UL << RCC_ICSCR_HSITRIM_Pos);
+  CHECK_EQ(Clock_GetHSIError(), 0);
+
+  // Back on HSI16, a fast oscillator is trimmed again
+  CHECK(Clock_SetSystemClock(SYSCLK_SRC_HSISYS));
+  TrimCaptures(33, 3950);
+  CHECK(Clock_GetHSIError() > 10000);
+  CHECK_EQ(hostRegs.rcc.ICSCR & RCC_ICSCR_HSITRIM, 63UL << RCC_ICSCR_HSITRIM_Pos);
+
+  Clock_StopHSITrim();
+}
+
+int main(void) {
+  TEST_RUN(TestUpshiftRaisesLatencyFirst);
+  TEST_RUN(TestDownshiftLowersLatencyAfter);
+  TEST_RUN(TestPrescalerCountsForLatency);
+  TEST_RUN(TestRefusedSwitchRestores);
+  TEST_RUN(TestUnlockedPLLIsRejected);
+  TEST_RUN(TestEconomyStopsPLL);
+  TEST_RUN(TestMaxReplacesForeignPLL);
+  TEST_RUN(TestWakeupKeepsAttachedLines);
+  TEST_RUN(TestStopNeedsAWakeSource);
+  TEST_RUN(TestTrimRestartsOnClockChange);
+
+  return TEST_RESULT("test_clock");
+}
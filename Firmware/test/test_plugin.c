@@ -0,0 +1,168 @@
+/**
+ * @file    test_plugin.c
+ * @brief   Host test of the compressed plugin record parser in vs1053_plugin.c
+ * @author  Joshua
+ * @date    2025-11-02
+ *
+ * The SCI driver is replaced by a log of multiple writes, so each test compares the register and
+ * words the loader sent against what the image describes. TIM2 stands in for the microsecond
+ * counter and only moves while VS1053_SCISync waits.
+ */
+
+#include "stm32g031xx.h"
+#include "test.h"
+#include "vs1053.h"
+#include "vs1053_plugin.h"
+
+#define LOG_MAX 64
+#define SYNC_US 250    // Time the last shadowed write needs to reach the decoder
+
+/**
+ * @brief One SCI multiple write as the loader issued it
+ */
+typedef struct {
+  uint8_t reg;
+  uint8_t count;
+  uint16_t first;
+  uint16_t last;
+  bool uniform;    // Every word equal to first
+} LogEntry;
+
+static LogEntry writeLog[LOG_MAX];
+static uint32_t writeCount;
+static uint32_t syncCalls;
+static uint32_t writesBeforeSync;
+static bool syncResult;
+
+bool VS1053_SCIWriteMulti(uint8_t reg, const uint16_t *values, uint8_t count) {
+  CHECK(count >= 1 && count <= VS1053_SCI_BATCH);
+  CHECK(writeCount < LOG_MAX);
+
+  LogEntry *entry = &writeLog[writeCount++ % LOG_MAX];
+  *entry          = (LogEntry){reg, count, values[0], values[count - 1], true};
+  for (uint8_t i = 1; i < count; i++)
+    if (values[i] != values[0])
+      entry->uniform = false;
+
+  return true;
+}
+
+bool VS1053_SCISync(void) {
+  syncCalls++;
+  writesBeforeSync = writeCount;
+  hostRegs.tim2.CNT += SYNC_US;
+  return syncResult;
+}
+
+static void Setup(void) {
+  Host_Reset();
+  writeCount = 0;
+  syncCalls  = 0;
+  syncResult = true;
+}
+
+static void TestRecordsSplitIntoBatches(void) {
+  Setup();
+
+  // 20 words to WRAM after a WRAMADDR record, then one word to AIADDR
+  uint16_t image[2 + 1 + 2 + 20 + 2 + 1] = {VS1053_SCI_WRAMADDR, 1, 0x8010, VS1053_SCI_WRAM, 20};
+  for (uint16_t i = 0; i < 20; i++)
+    image[5 + i] = 0x1000 + i;
+  image[25] = VS1053_SCI_AIADDR;
+  image[26] = 1;
+  image[27] = 0x0050;
+
+  CHECK(VS1053_LoadPluginImage(image, 28));
+  CHECK_EQ(writeCount, 4);
+
+  CHECK_EQ(writeLog[0].reg, VS1053_SCI_WRAMADDR);
+  CHECK_EQ(writeLog[0].count, 1);
+  CHECK_EQ(writeLog[0].first, 0x8010);
+
+  CHECK_EQ(writeLog[1].reg, VS1053_SCI_WRAM);
+  CHECK_EQ(writeLog[1].count, VS1053_SCI_BATCH);
+  CHECK_EQ(writeLog[1].first, 0x1000);
+  CHECK_EQ(writeLog[1].last, 0x1000 + VS1053_SCI_BATCH - 1);
+  CHECK_EQ(writeLog[2].reg, VS1053_SCI_WRAM);
+  CHECK_EQ(writeLog[2].count, 20 - VS1053_SCI_BATCH);
+  CHECK_EQ(writeLog[2].first, 0x1000 + VS1053_SCI_BATCH);
+  CHECK_EQ(writeLog[2].last, 0x1013);
+
+  CHECK_EQ(writeLog[3].reg, VS1053_SCI_AIADDR);
+  CHECK_EQ(writeLog[3].first, 0x0050);
+
+  const VS1053PluginStats *stats = VS1053_GetPluginStats();
+  CHECK_EQ(stats->image_bytes, 28 * 2);
+  CHECK_EQ(stats->words, 22);
+  CHECK_EQ(stats->transactions, 4);
+}
+
+static void TestRepeatExpands(void) {
+  Setup();
+
+  // 35 copies of one word from a three word record
+  const uint16_t image[] = {VS1053_SCI_WRAMADDR, 1, 0x1800, VS1053_SCI_WRAM, VS1053_PLUGIN_RLE | 35, 0xABCD};
+
+  CHECK(VS1053_LoadPluginImage(image, sizeof(image) / sizeof(image[0])));
+  CHECK_EQ(writeCount, 4);
+
+  uint32_t words = 0;
+  for (uint32_t i = 1; i < writeCount; i++) {
+    CHECK_EQ(writeLog[i].reg, VS1053_SCI_WRAM);
+    CHECK_EQ(writeLog[i].first, 0xABCD);
+    CHECK(writeLog[i].uniform);
+    words += writeLog[i].count;
+  }
+  CHECK_EQ(words, 35);
+  CHECK_EQ(writeLog[3].count, 35 - 2 * VS1053_SCI_BATCH);
+
+  const VS1053PluginStats *stats = VS1053_GetPluginStats();
+  CHECK_EQ(stats->image_bytes, sizeof(image));
+  CHECK_EQ(stats->words, 36);
+}
+
+static void TestTruncatedImageFails(void) {
+  Setup();
+
+  // Record announces three words, the image ends after two
+  const uint16_t shortRecord[] = {VS1053_SCI_WRAM, 3, 0x0001, 0x0002};
+  CHECK(!VS1053_LoadPluginImage(shortRecord, 4));
+
+  // Repeat without its value, and a header cut in half
+  const uint16_t shortRepeat[] = {VS1053_SCI_WRAM, VS1053_PLUGIN_RLE | 4};
+  CHECK(!VS1053_LoadPluginImage(shortRepeat, 2));
+  CHECK(!VS1053_LoadPluginImage(shortRepeat, 1));
+
+  CHECK_EQ(syncCalls, 0);
+
+  // An empty image is a clean end
+  CHECK(VS1053_LoadPluginImage(shortRecord, 0));
+}
+
+static void TestSyncsBeforeReturning(void) {
+  Setup();
+
+  // VOL is shadowed, its write may still be pending when the last record is parsed
+  const uint16_t image[] = {VS1053_SCI_WRAMADDR, 1, 0x8010, VS1053_SCI_VOL, 1, 0x2020};
+
+  hostRegs.tim2.CNT = 1000;
+  CHECK(VS1053_LoadPluginImage(image, 6));
+  CHECK_EQ(syncCalls, 1);
+  CHECK_EQ(writesBeforeSync, 2);
+
+  // The wait for the decoder counts as load time
+  CHECK(VS1053_GetPluginStats()->load_us >= SYNC_US);
+
+  Setup();
+  syncResult = false;
+  CHECK(!VS1053_LoadPluginImage(image, 6));
+}
+
+int main(void) {
+  TEST_RUN(TestRecordsSplitIntoBatches);
+  TEST_RUN(TestRepeatExpands);
+  TEST_RUN(TestTruncatedImageFails);
+  TEST_RUN(TestSyncsBeforeReturning);
+
+  return TEST_RESULT("test_plugin");
+}
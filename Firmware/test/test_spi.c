@@ -0,0 +1,170 @@
+/**
+ * @file    test_spi.c
+ * @brief   Host test of the programmed I/O path in spi.c against the simulated SPI1 FIFOs
+ * @author  Joshua
+ * @date    2025-11-02
+ *
+ * spi.c is included with its DR accessors routed to host/spi1.c, so every data register access
+ * is logged with its width and the FRXTH setting in force. Pairs of bytes must move as half-words
+ * with the half-word RX threshold, a trailing odd byte as a byte after FRXTH is set again, and no
+ * more than 4 bytes may be in flight however slowly the code runs.
+ */
+
+#include "spi1.h"
+
+#define SPI_READ_DR8() ((uint8_t)HostSpi_Read(8))
+#define SPI_READ_DR16() HostSpi_Read(16)
+#define SPI_WRITE_DR8(data) HostSpi_Write(8, (data))
+#define SPI_WRITE_DR16(data) HostSpi_Write(16, (data))
+
+#include "../lib/spi.c"
+
+#include "test.h"
+
+#define LEN_MAX 64
+
+static uint8_t txBuf[LEN_MAX];
+static uint8_t rxBuf[LEN_MAX];
+static uint32_t doneCalls;
+static bool doneOk;
+
+static void OnDone(bool ok, void *arg) {
+  (void)arg;
+  doneCalls++;
+  doneOk = ok;
+}
+
+/**
+ * @brief Fresh SPI1 at @p baud with @p access_cycles per peripheral access, test pattern in txBuf.
+ */
+static void Setup(SPIBaud baud, uint32_t access_cycles) {
+  Host_Reset();
+  SPI_Init(baud, SPI_MODE_0);
+  HostSpi_Reset(access_cycles);
+
+  for (uint16_t i = 0; i < LEN_MAX; i++) {
+    txBuf[i] = (uint8_t)(0x30 + i * 7);
+    rxBuf[i] = 0;
+  }
+  doneCalls = 0;
+  doneOk    = false;
+}
+
+/**
+ * @brief Runs the IRQ path to completion, the handler runs whenever RXNE is pending and enabled.
+ */
+static void RunIT(void) {
+  for (uint32_t i = 0; i < 100000 && !doneCalls; i++) {
+    HostSpi_Advance(1);
+    if ((hostRegs.spi1.SR & SPI_SR_RXNE) && (hostRegs.spi1.CR2 & SPI_CR2_RXNEIE))
+      SPI1_IRQHandler();
+  }
+}
+
+/**
+ * @brief Checks the data came back, the FIFOs were never misused and the access pattern for @p len bytes.
+ */
+static void CheckBytes(uint16_t len) {
+  for (uint16_t i = 0; i < len; i++)
+    CHECK_EQ(rxBuf[i], (uint8_t)~txBuf[i]);
+
+  CHECK_EQ(hostSpi.bytes, len);
+  CHECK_EQ(hostSpi.overruns, 0);
+  CHECK_EQ(hostSpi.bad_accesses, 0);
+  CHECK(hostSpi.max_inflight <= HOST_SPI_FIFO);
+
+  // Half-words with the half-word threshold, the odd byte alone with the byte threshold
+  CHECK_EQ(HostSpi_Count(true, 16, false), len / 2);
+  CHECK_EQ(HostSpi_Count(false, 16, false), len / 2);
+  CHECK_EQ(HostSpi_Count(true, 8, true) + HostSpi_Count(true, 8, false), len % 2);
+  CHECK_EQ(HostSpi_Count(false, 8, true), len % 2);
+  CHECK_EQ(hostSpi.log_len, len / 2 * 2 + len % 2 * 2);
+
+  // The last read is the odd byte, every one before it a half-word
+  if (len % 2) {
+    CHECK(!hostSpi.log[hostSpi.log_len - 1].write);
+    CHECK_EQ(hostSpi.log[hostSpi.log_len - 1].width, 8);
+  }
+
+  // Byte threshold restored for the DMA path, no interrupt left enabled
+  CHECK(hostRegs.spi1.CR2 & SPI_CR2_FRXTH);
+  CHECK(!(hostRegs.spi1.CR2 & SPI_CR2_RXNEIE));
+  CHECK(!SPI_IsBusy());
+}
+
+static void TestPolledLengths(void) {
+  static const uint16_t lengths[] = {1, 2, 3, 4, 7, 8, 15, 16, 33};
+
+  for (uint8_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+    Setup(SPI_BAUD_DIV_8, 4);
+    CHECK(SPI_TransferPolled(txBuf, rxBuf, lengths[i]));
+    CheckBytes(lengths[i]);
+  }
+}
+
+static void TestITLengths(void) {
+  static const uint16_t lengths[] = {1, 2, 5, 6, 15};
+
+  for (uint8_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+    Setup(SPI_BAUD_DIV_8, 4);
+    CHECK(SPI_TransferIT(txBuf, rxBuf, lengths[i], OnDone, NULL));
+    RunIT();
+    CHECK_EQ(doneCalls, 1);
+    CHECK(doneOk);
+    CheckBytes(lengths[i]);
+  }
+}
+
+static void TestSlowCodeFastClock(void) {
+  // Each access takes longer than four bytes on the wire, the FIFOs must still never overflow
+  Setup(SPI_BAUD_DIV_2, 80);
+  CHECK(SPI_TransferPolled(txBuf, rxBuf, 15));
+  CheckBytes(15);
+
+  Setup(SPI_BAUD_DIV_2, 80);
+  CHECK(SPI_TransferIT(txBuf, rxBuf, 15, OnDone, NULL));
+  RunIT();
+  CHECK_EQ(doneCalls, 1);
+  CheckBytes(15);
+}
+
+static void TestReceiveOnlyAndTransmitOnly(void) {
+  Setup(SPI_BAUD_DIV_4, 4);
+  CHECK(SPI_TransferPolled(NULL, rxBuf, 5));
+  for (uint8_t i = 0; i < 5; i++)
+    CHECK_EQ(rxBuf[i], (uint8_t)~SPI_DUMMY_FRAME);
+  CHECK_EQ(hostSpi.bytes, 5);
+
+  Setup(SPI_BAUD_DIV_4, 4);
+  CHECK(SPI_TransferPolled(txBuf, NULL, 5));
+  CHECK_EQ(hostSpi.bytes, 5);
+  CHECK_EQ(rxBuf[0], 0);
+  CHECK_EQ(hostSpi.rx_level, 0);
+}
+
+static void TestWideFrames(void) {
+  Setup(SPI_BAUD_DIV_4, 4);
+  CHECK(SPI_SetFormat(SPI_BAUD_DIV_4, SPI_MODE_0, 16));
+
+  // Three 16-bit frames, all half-word accesses with the half-word threshold
+  CHECK(SPI_TransferPolled(txBuf, rxBuf, 3));
+  for (uint8_t i = 0; i < 6; i++)
+    CHECK_EQ(rxBuf[i], (uint8_t)~txBuf[i]);
+
+  CHECK_EQ(hostSpi.bytes, 6);
+  CHECK_EQ(HostSpi_Count(true, 16, false), 3);
+  CHECK_EQ(HostSpi_Count(false, 16, false), 3);
+  CHECK_EQ(hostSpi.log_len, 6);
+  CHECK_EQ(hostSpi.bad_accesses, 0);
+  CHECK(hostSpi.max_inflight <= HOST_SPI_FIFO);
+}
+
+int main(void) {
+  TEST_RUN(TestPolledLengths);
+  TEST_RUN(TestITLengths);
+  TEST_RUN(TestSlowCodeFastClock);
+  TEST_RUN(TestReceiveOnlyAndTransmitOnly);
+  TEST_RUN(TestWideFrames);
+
+  return TEST_RESULT("test_spi");
+}
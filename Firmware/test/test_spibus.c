@@ -0,0 +1,185 @@
+/**
+ * @file    test_spibus.c
+ * @brief   Host test of clock changes against transfers running on the SPI1 arbiter
+ * @author  Joshua
+ * @date    2025-11-02
+ *
+ * The DMA driver is replaced by stubs that keep the started transfer in flight until the test
+ * completes it. A clock change callback checks that SCK never leaves a device's limit while a
+ * transfer is on the wire, the governor and the real clock.c do the switching.
+ */
+
+#include "clock.h"
+#include "governor.h"
+#include "spibus.h"
+#include "stm32g031xx.h"
+#include "test.h"
+
+/**
+ * @brief Transfer the stub SPI driver is running
+ */
+typedef struct {
+  bool running;
+  SPIBaud baud;
+  uint32_t limit;    // max_hz of the device it was started for
+  SPICallback callback;
+  void *arg;
+} Wire;
+
+static Wire wire;
+
+static SPIBaud programmed = SPI_BAUD_DIV_256;
+static uint32_t started;
+static uint32_t violations;
+
+void SPI_Init(SPIBaud baud, SPIMode mode) {
+  (void)mode;
+  programmed = baud;
+}
+
+bool SPI_SetFormat(SPIBaud baud, SPIMode mode, uint8_t bits) {
+  (void)mode;
+  (void)bits;
+  CHECK(!wire.running);
+  programmed = baud;
+  return true;
+}
+
+static bool Wire_Start(SPICallback callback, void *arg) {
+  CHECK(!wire.running);
+
+  wire = (Wire){true, programmed, 0, callback, arg};
+  started++;
+  return true;
+}
+
+bool SPI_Transmit(const uint8_t *tx, uint16_t len, SPICallback callback, void *arg) {
+  (void)tx;
+  (void)len;
+  return Wire_Start(callback, arg);
+}
+
+bool SPI_Receive(uint8_t *rx, uint16_t len, SPICallback callback, void *arg) {
+  (void)rx;
+  (void)len;
+  return Wire_Start(callback, arg);
+}
+
+bool SPI_TransmitReceive(const uint8_t *tx, uint8_t *rx, uint16_t len, SPICallback callback, void *arg) {
+  (void)tx;
+  (void)rx;
+  (void)len;
+  return Wire_Start(callback, arg);
+}
+
+bool SPI_TransferIT(const uint8_t *tx, uint8_t *rx, uint16_t len, SPICallback callback, void *arg) {
+  (void)tx;
+  (void)rx;
+  (void)len;
+  return Wire_Start(callback, arg);
+}
+
+/**
+ * @brief SCK of the transfer on the wire at the current PCLK.
+ */
+static uint32_t Wire_SCK(void) {
+  return Clock_GetPCLK() >> (wire.baud + 1);
+}
+
+/**
+ * @brief Registered after the bus, checks the transfer on the wire against its device limit.
+ */
+static void Wire_OnClockChange(const ClockTree *tree) {
+  (void)tree;
+  if (wire.running && Wire_SCK() > wire.limit)
+    violations++;
+}
+
+/**
+ * @brief Lets the transfer on the wire finish, the arbiter starts the next queued one.
+ */
+static void Wire_Complete(void) {
+  CHECK(wire.running);
+  wire.running = false;
+  wire.callback(true, wire.arg);
+}
+
+/**
+ * @brief Submits a transfer and records the limit of its device if it starts at once.
+ */
+static void Submit(SPIBusTransfer *transfer) {
+  bool idle = !wire.running;
+  CHECK(SPIBus_Submit(transfer));
+
+  if (idle && wire.running) {
+    wire.limit = SPIBus_GetProfile(transfer->device)->max_hz;
+    CHECK(Wire_SCK() <= wire.limit);
+  }
+}
+
+static void Setup(void) {
+  Host_Reset();
+  CHECK(Clock_ApplyProfile(CLOCK_PROFILE_PLAYBACK_ECONOMY));
+  CHECK(Governor_SetLevel(GOVERNOR_LEVEL_ECONOMY));
+  Governor_Init();
+
+  SPIBus_Init();
+  Clock_RegisterChangeCallback(Wire_OnClockChange);
+  wire       = (Wire){0};
+  started    = 0;
+  violations = 0;
+}
+
+static void TestClockChangeWaitsForTransfer(void) {
+  static uint8_t buffer[32];
+  SPIBusTransfer sd  = {.device = SPIBUS_DEVICE_SD, .rx = buffer, .len = sizeof(buffer)};
+  SPIBusTransfer sdi = {.device = SPIBUS_DEVICE_SDI, .tx = buffer, .len = sizeof(buffer)};
+
+  Setup();
+  CHECK_EQ(Clock_GetPCLK(), 4000000UL);
+
+  // SD still at the 400 kHz identification limit, a SDI burst queued behind it
+  Submit(&sd);
+  Submit(&sdi);
+  CHECK(wire.running);
+  CHECK_EQ(started, 1);
+
+  // Buffer low in the middle of the SD read: 16x PCLK would put SCK at 4 MHz
+  CHECK(!Governor_SetLevel(GOVERNOR_LEVEL_MAX));
+  CHECK_EQ(Clock_GetPCLK(), 4000000UL);
+  CHECK_EQ(Governor_GetLevel(), GOVERNOR_LEVEL_ECONOMY);
+  CHECK_EQ(Governor_GetStats()->deferred_transitions, 1);
+
+  // The queued burst starts as soon as the read is done, still not safe
+  Wire_Complete();
+  wire.limit = SPIBus_GetProfile(SPIBUS_DEVICE_SDI)->max_hz;
+  CHECK(wire.running);
+  CHECK(!Governor_SetLevel(GOVERNOR_LEVEL_MAX));
+
+  // Bus idle, the switch goes through and the next transfer gets a new prescaler
+  Wire_Complete();
+  CHECK(Governor_SetLevel(GOVERNOR_LEVEL_MAX));
+  CHECK_EQ(Clock_GetPCLK(), 64000000UL);
+
+  Submit(&sd);
+  CHECK(wire.running);
+  CHECK_EQ(wire.baud, SPI_BAUD_DIV_256);
+  CHECK(Wire_SCK() <= SPIBUS_SD_INIT_HZ);
+  Wire_Complete();
+
+  // And back down between transfers
+  Submit(&sdi);
+  CHECK(!Governor_SetLevel(GOVERNOR_LEVEL_ECONOMY));
+  Wire_Complete();
+  CHECK(Governor_SetLevel(GOVERNOR_LEVEL_ECONOMY));
+
+  CHECK_EQ(violations, 0);
+  CHECK_EQ(Governor_GetStats()->deferred_transitions, 3);
+  CHECK_EQ(hostPrimask, 0);
+}
+
+int main(void) {
+  TEST_RUN(TestClockChangeWaitsForTransfer);
+
+  return TEST_RESULT("test_spibus");
+}
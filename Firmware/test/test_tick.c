@@ -0,0 +1,190 @@
+/**
+ * @file    test_tick.c
+ * @brief   Host test of the tickless idle deadline and compensation maths in tick.c
+ * @author  Joshua
+ * @date    2025-11-02
+ *
+ * tick.c is included directly for its static helpers, the clock driver is replaced by stubs so
+ * each test picks the LSI frequency, the wake sources and what the Stop leaves in LPTIM1->CNT.
+ */
+
+#include "../lib/tick.c"
+
+#include "test.h"
+
+static uint32_t stubLsi;
+static uint8_t stubWake;
+static bool stubStopResult;
+static uint32_t stubStopCounts;
+static uint32_t stopCalls;
+static uint32_t sleepCalls;
+static uint32_t stubHclk = 16000000UL;
+
+uint32_t Clock_GetLSI(void) {
+  return stubLsi;
+}
+
+bool Clock_IsReady(ClockBase source) {
+  (void)source;
+  return true;
+}
+
+uint8_t Clock_GetWakeup(void) {
+  return stubWake;
+}
+
+bool Clock_EnterStopMode(uint8_t wake) {
+  CHECK(wake & CLOCK_WAKE_LPTIM);
+  CHECK(!(hostRegs.systick.CTRL & SysTick_CTRL_ENABLE_Msk));
+
+  stopCalls++;
+  hostRegs.lptim1.CNT = stubStopCounts;
+  return stubStopResult;
+}
+
+bool Clock_EnterSleepMode(void) {
+  sleepCalls++;
+  return true;
+}
+
+bool Clock_RegisterChangeCallback(ClockChangeCallback callback) {
+  (void)callback;
+  return true;
+}
+
+uint32_t Clock_GetHCLK(void) {
+  return stubHclk;
+}
+
+/**
+ * @brief Resets the simulated chip and the tick state, LPTIM1 allowed to wake the core.
+ */
+static void Setup(uint32_t lsi) {
+  Host_Reset();
+  Tick_Init();
+
+  ticks          = 0;
+  idleResidual   = 0;
+  tickFraction   = 0;
+  stubHclk       = 16000000UL;
+  stubLsi        = lsi;
+  stubWake       = CLOCK_WAKE_LPTIM;
+  stubStopResult = true;
+  stopCalls      = 0;
+  sleepCalls     = 0;
+}
+
+static void TestMsToCountsRoundsDown(void) {
+  CHECK_EQ(Tick_MsToCounts(1000, 32000), 1000);
+  CHECK_EQ(Tick_MsToCounts(10, 32768), 10);       // 10.24 counts
+  CHECK_EQ(Tick_MsToCounts(100, 33000), 103);     // 103.125 counts
+  CHECK_EQ(Tick_MsToCounts(1, 16000), 0);         // Half a count, too short for Stop
+  CHECK_EQ(Tick_MsToCounts(100000, 32000), TICK_LPTIM_MAX);
+}
+
+static void TestCountsToMsCarriesResidual(void) {
+  Setup(32768);
+
+  // 1024 counts of 32 / 32768 s add up to exactly one second, one at a time
+  uint32_t total = 0;
+  for (uint32_t i = 0; i < 1024; i++)
+    total += Tick_CountsToMs(1, 32768);
+
+  CHECK_EQ(total, 1000);
+  CHECK_EQ(idleResidual, 0);
+}
+
+static void TestStopNeverOversleeps(void) {
+  Setup(33000);
+
+  // Woken by the compare match
+  stubStopCounts = Tick_MsToCounts(100, 33000);
+  uint32_t idled = Tick_IdleUntil(100);
+
+  CHECK_EQ(stopCalls, 1);
+  CHECK_EQ(hostRegs.lptim1.CMP, 103);
+  CHECK_EQ(idled, 99);    // 103 counts are 99.9 ms, the rest is carried
+  CHECK(Tick_Now() <= 100);
+  CHECK_EQ(hostRegs.lptim1.CR, 0);
+  CHECK(hostRegs.systick.CTRL & SysTick_CTRL_ENABLE_Msk);
+}
+
+static void TestSleepsWithoutLptimWake(void) {
+  Setup(32000);
+  stubWake = CLOCK_WAKE_EXTI;
+
+  CHECK_EQ(Tick_IdleUntil(100), 0);
+  CHECK_EQ(stopCalls, 0);
+  CHECK_EQ(sleepCalls, 1);
+  CHECK_EQ(hostRegs.lptim1.CR, 0);    // Never started
+}
+
+static void TestShortIdleSleeps(void) {
+  Setup(32000);
+
+  CHECK_EQ(Tick_IdleUntil(1), 0);
+  CHECK_EQ(Tick_IdleUntil(0), 0);
+  CHECK_EQ(stopCalls, 0);
+  CHECK_EQ(sleepCalls, 1);
+}
+
+static void TestCompensatesFailedRestore(void) {
+  Setup(32000);
+
+  // Stopped for 40 ms, then the PLL did not relock
+  stubStopResult = false;
+  stubStopCounts = 40;
+
+  CHECK_EQ(Tick_IdleUntil(100), 40);
+  CHECK_EQ(Tick_Now(), 40);
+  CHECK_EQ(sleepCalls, 0);
+  CHECK_EQ(hostRegs.lptim1.CR, 0);
+  CHECK(hostRegs.systick.CTRL & SysTick_CTRL_ENABLE_Msk);
+}
+
+/**
+ * @brief Lets SysTick count @p done of the current tick, like the hardware between two reloads.
+ */
+static void SysTickRun(uint32_t done) {
+  hostRegs.systick.VAL = hostRegs.systick.LOAD + 1 - done;
+}
+
+static void TestClockChangeKeepsPartialTick(void) {
+  Setup(32000);
+
+  // Three quarters of a tick at 64 MHz, then half a tick at 16 MHz: one tick and a quarter
+  stubHclk = 64000000UL;
+  Tick_Reconfigure();
+  SysTickRun(48000);
+  stubHclk = 16000000UL;
+  Tick_Reconfigure();
+  CHECK_EQ(hostRegs.systick.LOAD, 15999);
+  CHECK_EQ(Tick_Now(), 0);
+
+  SysTickRun(8000);
+  Tick_Reconfigure();
+  CHECK_EQ(Tick_Now(), 1);
+  CHECK(hostRegs.systick.CTRL & SysTick_CTRL_ENABLE_Msk);
+
+  // A governor switching every 10 ms halfway through a tick loses nothing over a second
+  for (uint32_t i = 0; i < 100; i++) {
+    stubHclk = (i & 1) ? 16000000UL : 4000000UL;
+    Tick_Reconfigure();
+    ticks += 9;
+    SysTickRun((hostRegs.systick.LOAD + 1) / 2);
+  }
+  Tick_Reconfigure();
+  CHECK_EQ(Tick_Now(), 1 + 100 * 9 + 50);
+}
+
+int main(void) {
+  TEST_RUN(TestMsToCountsRoundsDown);
+  TEST_RUN(TestCountsToMsCarriesResidual);
+  TEST_RUN(TestStopNeverOversleeps);
+  TEST_RUN(TestSleepsWithoutLptimWake);
+  TEST_RUN(TestShortIdleSleeps);
+  TEST_RUN(TestCompensatesFailedRestore);
+  TEST_RUN(TestClockChangeKeepsPartialTick);
+
+  return TEST_RESULT("test_tick");
+}
@@ -0,0 +1,178 @@
+/**
+ * @file    test_timer.c
+ * @brief   Host test of the timer wheel around its level boundaries
+ * @author  Joshua
+ * @date    2025-11-02
+ *
+ * Tick_Now is a plain variable here, the tests move it and call Timer_Process like the main loop.
+ * Every callback checks that it runs on the exact tick its timer was due.
+ */
+
+#include "stm32g031xx.h"
+#include "test.h"
+#include "tick.h"
+#include "timer.h"
+
+static uint32_t now;
+
+uint32_t Tick_Now(void) {
+  return now;
+}
+
+/**
+ * @brief Expected expiry and firing log of one test timer
+ */
+typedef struct {
+  Timer timer;
+  uint32_t due;       // Tick the next expiry must run on
+  uint32_t period;    // Step of due after each expiry
+  uint32_t fired;     // Callback count
+} Probe;
+
+static void Probe_Fire(void *arg) {
+  Probe *probe = arg;
+
+  if (now != probe->due)
+    printf("    timer due at %u fired at %u\n", (unsigned)probe->due, (unsigned)now);
+  CHECK_EQ(now, probe->due);
+
+  probe->due += probe->period;
+  probe->fired++;
+}
+
+static void Probe_Start(Probe *probe, uint32_t ms, uint32_t period) {
+  Timer_Setup(&probe->timer, Probe_Fire, probe);
+  probe->due    = now + ms;
+  probe->period = period;
+  probe->fired  = 0;
+  Timer_Start(&probe->timer, ms, period);
+}
+
+/**
+ * @brief Runs the main loop one tick at a time up to @p until.
+ */
+static void Step(uint32_t until) {
+  while (now != until) {
+    now++;
+    Timer_Process();
+  }
+}
+
+static void TestOneShotOnBoundaries(void) {
+  static const uint32_t delays[] = {1, 63, 64, 65, 127, 128, 4095, 4096, 4097, 8192, TIMER_MAX_MS, 300000};
+  static const uint32_t starts[] = {0, 1, 37, 63, 64, 4095, 0xFFFFFF00UL};
+
+  for (uint32_t s = 0; s < sizeof(starts) / sizeof(starts[0]); s++) {
+    for (uint32_t d = 0; d < sizeof(delays) / sizeof(delays[0]); d++) {
+      Probe probe;
+
+      now = starts[s];
+      Timer_Init();
+      Probe_Start(&probe, delays[d], 0);
+
+      Step(starts[s] + delays[d] + 2);
+      CHECK_EQ(probe.fired, 1);
+      CHECK(!Timer_IsActive(&probe.timer));
+    }
+  }
+}
+
+static void TestPeriodicOnBoundaries(void) {
+  static const uint32_t periods[] = {1, 64, 128, 4096};
+
+  for (uint32_t p = 0; p < sizeof(periods) / sizeof(periods[0]); p++) {
+    Probe probe;
+
+    now = 0;
+    Timer_Init();
+    Probe_Start(&probe, periods[p], periods[p]);
+
+    // 128 ms fires at 128, 256, 384 ... never a tick late
+    Step(periods[p] * 20);
+    CHECK_EQ(probe.fired, 20);
+    Timer_Stop(&probe.timer);
+  }
+}
+
+static void TestLateProcessCatchesUp(void) {
+  Probe probes[3];
+
+  now = 0;
+  Timer_Init();
+  Probe_Start(&probes[0], 64, 0);
+  Probe_Start(&probes[1], 128, 0);
+  Probe_Start(&probes[2], 5000, 0);
+
+  // A long idle, the whole batch runs late but in one pass
+  now = 6000;
+  probes[0].due = probes[1].due = probes[2].due = now;
+  Timer_Process();
+
+  CHECK_EQ(probes[0].fired + probes[1].fired + probes[2].fired, 3);
+  CHECK_EQ(hostPrimask, 0);
+}
+
+static void TestStartAfterIdleWheel(void) {
+  Probe probe;
+
+  now = 0;
+  Timer_Init();
+
+  // Nothing armed for longer than the wheel spans, Timer_Process never ran on the way
+  now = 4 * TIMER_MAX_MS;
+  Probe_Start(&probe, 10, 0);
+  CHECK_EQ(Timer_NextDeadline(), now + 10);
+
+  Step(now + 12);
+  CHECK_EQ(probe.fired, 1);
+}
+
+static void TestNextDeadlineIsExact(void) {
+  enum { PROBES = 24 };
+  Probe probes[PROBES];
+  uint32_t seed = 12345;
+
+  now = 1000;
+  Timer_Init();
+
+  for (uint32_t i = 0; i < PROBES; i++) {
+    seed = seed * 1103515245UL + 12345UL;
+    uint32_t ms = 1 + (seed >> 8) % 20000;
+
+    // Every fourth probe is periodic, some right on a level boundary
+    if (i % 8 == 0)
+      ms = 64UL << (i / 8);
+    Probe_Start(&probes[i], ms, (i % 4 == 0) ? ms : 0);
+  }
+
+  // Jump straight to each deadline like the tickless idle does, every wake must fire something
+  uint32_t wakes = 0;
+  while (now < 1000 + 60000) {
+    uint32_t deadline = Timer_NextDeadline();
+    CHECK((int32_t)(deadline - now) > 0);
+
+    uint32_t before = 0, after = 0;
+    for (uint32_t i = 0; i < PROBES; i++)
+      before += probes[i].fired;
+
+    now = deadline;
+    Timer_Process();
+    wakes++;
+
+    for (uint32_t i = 0; i < PROBES; i++)
+      after += probes[i].fired;
+    CHECK(after > before);
+  }
+
+  CHECK(wakes > PROBES);
+}
+
+int main(void) {
+  TEST_RUN(TestOneShotOnBoundaries);
+  TEST_RUN(TestPeriodicOnBoundaries);
+  TEST_RUN(TestLateProcessCatchesUp);
+  TEST_RUN(TestStartAfterIdleWheel);
+  TEST_RUN(TestNextDeadlineIsExact);
+
+  return TEST_RESULT("test_timer");
+}
@@ -0,0 +1,221 @@
+/**
+ * @file    test_vs1053.c
+ * @brief   Host test of the SCI register shadow in vs1053.c
+ * @author  Joshua
+ * @date    2025-11-02
+ *
+ * SPIBus_Submit hands each SCI transaction to a small decoder model that keeps a register file,
+ * the transfer completes on the next Tick_Expired poll like a DMA finishing during a wait loop.
+ * The model clears SM_CANCEL only after a few reads and drops every register on SM_RESET, so the
+ * tests see what the driver answers from the shadow and what it fetches from the bus.
+ */
+
+#include "exti.h"
+#include "spibus.h"
+#include "stm32g031xx.h"
+#include "test.h"
+#include "tick.h"
+#include "vs1053.h"
+
+#define MODEL_OP_READ 0x03
+#define MODEL_SM_SDINEW 0x0800
+
+static uint16_t modelReg[16];
+static uint8_t modelCancelReads;    // MODE reads still showing SM_CANCEL
+static SPIBusTransfer *pending;
+
+/**
+ * @brief Executes one SCI transaction against the register file.
+ */
+static void Model_Execute(SPIBusTransfer *transfer) {
+  const uint8_t *tx = transfer->tx;
+  uint8_t reg       = tx[1];
+
+  if (tx[0] == MODEL_OP_READ) {
+    if (reg == VS1053_SCI_MODE && (modelReg[reg] & VS1053_SM_CANCEL) && !modelCancelReads--)
+      modelReg[reg] &= ~VS1053_SM_CANCEL;
+    transfer->rx[2] = (uint8_t)(modelReg[reg] >> 8);
+    transfer->rx[3] = (uint8_t)modelReg[reg];
+    return;
+  }
+
+  for (uint16_t i = 2; i + 1 < transfer->len; i += 2)
+    modelReg[reg] = (uint16_t)((tx[i] << 8) | tx[i + 1]);
+
+  if (reg == VS1053_SCI_MODE && (modelReg[reg] & VS1053_SM_RESET)) {
+    uint16_t mode = modelReg[reg] & ~VS1053_SM_RESET;
+    for (uint8_t i = 0; i < 16; i++)
+      modelReg[i] = 0;
+    modelReg[VS1053_SCI_MODE] = mode;
+  }
+}
+
+bool SPIBus_Submit(SPIBusTransfer *transfer) {
+  CHECK(transfer->device == SPIBUS_DEVICE_SCI);
+  CHECK(!pending);
+
+  pending = transfer;
+  return true;
+}
+
+void SPIBus_SetSpeed(SPIBusDevice device, uint32_t max_hz) {
+  (void)device;
+  (void)max_hz;
+}
+
+uint32_t SPIBus_GetClock(SPIBusDevice device) {
+  (void)device;
+  return 0;
+}
+
+bool EXTI_Attach(GPIO_TypeDef *port, uint8_t pin, EXTIEdge edge, EXTICallback callback, uint8_t priority) {
+  (void)port;
+  (void)pin;
+  (void)edge;
+  (void)callback;
+  (void)priority;
+  return true;
+}
+
+uint32_t Tick_Deadline(uint32_t ms) {
+  return ms;
+}
+
+bool Tick_Expired(uint32_t deadline) {
+  (void)deadline;
+
+  // The transfer in flight completes while the driver waits
+  SPIBusTransfer *transfer = pending;
+  if (transfer) {
+    pending = NULL;
+    Model_Execute(transfer);
+    transfer->callback(true, transfer->arg);
+  }
+  return false;
+}
+
+void Tick_Delay(uint32_t ms) {
+  (void)ms;
+}
+
+/**
+ * @brief Fresh decoder model and an empty shadow, DREQ high.
+ */
+static void Setup(void) {
+  Host_Reset();
+  hostRegs.gpiob.IDR = 1UL << 1;
+
+  for (uint8_t i = 0; i < 16; i++)
+    modelReg[i] = 0;
+  modelCancelReads = 0;
+
+  CHECK(VS1053_SCISync());
+  VS1053_SCIInvalidate();
+}
+
+static void TestAudataReadFromBus(void) {
+  Setup();
+  const VS1053SCIStats *stats = VS1053_SCIGetStats();
+  uint16_t value              = 0;
+
+  CHECK(VS1053_SCIWrite(VS1053_SCI_AUDATA, 44101));
+  CHECK(VS1053_SCISync());
+  CHECK_EQ(modelReg[VS1053_SCI_AUDATA], 44101);
+
+  // The decoder parsed a new stream header
+  modelReg[VS1053_SCI_AUDATA] = 48001;
+
+  uint32_t reads = stats->bus_reads;
+  CHECK(VS1053_SCIRead(VS1053_SCI_AUDATA, &value));
+  CHECK_EQ(value, 48001);
+  CHECK(VS1053_SCIRead(VS1053_SCI_AUDATA, &value));
+  CHECK_EQ(stats->bus_reads - reads, 2);
+
+  // Writing the value the host last wrote is not skipped, the chip holds another one
+  uint32_t writes = stats->bus_writes;
+  CHECK(VS1053_SCIWrite(VS1053_SCI_AUDATA, 44101));
+  CHECK(VS1053_SCISync());
+  CHECK_EQ(stats->bus_writes - writes, 1);
+  CHECK_EQ(modelReg[VS1053_SCI_AUDATA], 44101);
+}
+
+static void TestCancelPolledOnBus(void) {
+  Setup();
+  const VS1053SCIStats *stats = VS1053_SCIGetStats();
+  uint16_t value              = 0;
+
+  CHECK(VS1053_SCIWrite(VS1053_SCI_MODE, MODEL_SM_SDINEW));
+  CHECK(VS1053_SCISync());
+  CHECK(VS1053_SCIRead(VS1053_SCI_MODE, &value));
+
+  // The cancel goes out at once and is still set on the first two reads
+  modelCancelReads = 2;
+  uint32_t writes  = stats->bus_writes;
+  CHECK(VS1053_SCIWrite(VS1053_SCI_MODE, MODEL_SM_SDINEW | VS1053_SM_CANCEL));
+  CHECK_EQ(stats->bus_writes - writes, 1);
+
+  uint32_t reads = stats->bus_reads;
+  CHECK(VS1053_SCIRead(VS1053_SCI_MODE, &value));
+  CHECK_EQ(value, MODEL_SM_SDINEW | VS1053_SM_CANCEL);
+  CHECK(VS1053_SCIRead(VS1053_SCI_MODE, &value));
+  CHECK_EQ(value, MODEL_SM_SDINEW | VS1053_SM_CANCEL);
+  CHECK(VS1053_SCIRead(VS1053_SCI_MODE, &value));
+  CHECK_EQ(value, MODEL_SM_SDINEW);
+  CHECK_EQ(stats->bus_reads - reads, 3);
+
+  // Cleared, the shadow answers again
+  uint32_t saved = stats->saved_reads;
+  CHECK(VS1053_SCIRead(VS1053_SCI_MODE, &value));
+  CHECK_EQ(value, MODEL_SM_SDINEW);
+  CHECK_EQ(stats->bus_reads - reads, 3);
+  CHECK_EQ(stats->saved_reads - saved, 1);
+}
+
+static void TestResetNotShadowed(void) {
+  Setup();
+  const VS1053SCIStats *stats = VS1053_SCIGetStats();
+  uint16_t value              = 0;
+
+  CHECK(VS1053_SCIWrite(VS1053_SCI_VOL, 0x2020));
+  CHECK(VS1053_SCISync());
+
+  // Two resets in a row both reach the chip
+  uint32_t writes = stats->bus_writes;
+  CHECK(VS1053_SCIWrite(VS1053_SCI_MODE, MODEL_SM_SDINEW | VS1053_SM_RESET));
+  CHECK(VS1053_SCIWrite(VS1053_SCI_MODE, MODEL_SM_SDINEW | VS1053_SM_RESET));
+  CHECK_EQ(stats->bus_writes - writes, 2);
+
+  // The reset dropped VOL, the shadow must not answer the value from before it
+  CHECK(VS1053_SCIRead(VS1053_SCI_VOL, &value));
+  CHECK_EQ(value, 0);
+  CHECK(VS1053_SCIRead(VS1053_SCI_MODE, &value));
+  CHECK_EQ(value, MODEL_SM_SDINEW);
+
+  // SM_RESET never lingers in the shadow
+  CHECK(VS1053_SCIRead(VS1053_SCI_MODE, &value));
+  CHECK_EQ(value, MODEL_SM_SDINEW);
+}
+
+static void TestMultiCountsOnlyShadowedMerges(void) {
+  Setup();
+  const VS1053SCIStats *stats = VS1053_SCIGetStats();
+  const uint16_t words[4]     = {0x1111, 0x2222, 0x3333, 0x4444};
+
+  uint32_t saved = stats->saved_writes;
+  CHECK(VS1053_SCIWriteMulti(VS1053_SCI_WRAM, words, 4));
+  CHECK_EQ(stats->saved_writes - saved, 0);
+
+  CHECK(VS1053_SCIWriteMulti(VS1053_SCI_VOL, words, 4));
+  CHECK(VS1053_SCISync());
+  CHECK_EQ(stats->saved_writes - saved, 3);
+  CHECK_EQ(modelReg[VS1053_SCI_VOL], 0x4444);
+}
+
+int main(void) {
+  TEST_RUN(TestAudataReadFromBus);
+  TEST_RUN(TestCancelPolledOnBus);
+  TEST_RUN(TestResetNotShadowed);
+  TEST_RUN(TestMultiCountsOnlyShadowedMerges);
+
+  return TEST_RESULT("test_vs1053");
+}